@@ -0,0 +1,115 @@
+/*
+ * adc_stream.h
+ *
+ * Binary ADC10 telemetry stream, shared by the MSP430 firmware (main.c) and
+ * the Linux receiver (host/). Plain C99, it also builds as C++.
+ *
+ * Packet (all multi-byte fields little endian):
+ *
+ *   offset  size  field
+ *   0       2     sync       0xA5 0x5A
+ *   2       2     seq        packet counter, a gap means lost packets
+ *   4       2     rate       sample rate in Hz
+ *   6       1     channel    ADC10 input (INCH_x >> 12)
+ *   7       1     count      valid samples (ADCS_SAMPLES_PER_PACKET)
+ *   8       40    payload    32 samples x 10 bits, LSB first bit stream
+ *   48      2     crc        CRC-16/CCITT-FALSE of bytes 2..47
+ *
+ * 50 bytes carry 32 samples: at 115200 baud (11520 bytes/s) the link moves
+ * 7372 samples/s, against 1920 samples/s for "1023\r\n" style ASCII.
+ */
+
+#ifndef ADC_STREAM_H_
+#define ADC_STREAM_H_
+
+#include <stdint.h>
+
+/* Defines -----------------------*/
+#define ADCS_SYNC0                  (0xA5)
+#define ADCS_SYNC1                  (0x5A)
+#define ADCS_SAMPLES_PER_PACKET     (32)    // Multiple of 4 (4 samples in 5 bytes)
+#define ADCS_HEADER_SIZE            (8)
+#define ADCS_PAYLOAD_SIZE           (ADCS_SAMPLES_PER_PACKET*10/8)
+#define ADCS_CRC_SIZE               (2)
+#define ADCS_PACKET_SIZE            (ADCS_HEADER_SIZE + ADCS_PAYLOAD_SIZE + ADCS_CRC_SIZE)
+
+#define ADCS_OFFSET_SEQ             (2)
+#define ADCS_OFFSET_RATE            (4)
+#define ADCS_OFFSET_CHANNEL         (6)
+#define ADCS_OFFSET_COUNT           (7)
+#define ADCS_OFFSET_PAYLOAD         (ADCS_HEADER_SIZE)
+#define ADCS_OFFSET_CRC             (ADCS_HEADER_SIZE + ADCS_PAYLOAD_SIZE)
+
+#define ADCS_CRC_INIT               (0xFFFF)
+
+/* Functions ---------------------*/
+static inline uint16_t adcs_crc16(uint16_t crc, const uint8_t *data, uint16_t len)
+{
+    // CRC-16/CCITT-FALSE (0x1021), one nibble per lookup
+    static const uint16_t table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+    };
+
+    while(len--)
+    {
+        crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (*data >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (*data & 0x0F)]);
+        data++;
+    }
+
+    return crc;
+}
+
+// Pack 4 samples (10 bits) into 5 bytes
+static inline void adcs_pack4(uint8_t *out, const uint16_t *s)
+{
+    out[0] = (uint8_t)(s[0]);
+    out[1] = (uint8_t)(((s[0] >> 8) & 0x03) | (s[1] << 2));
+    out[2] = (uint8_t)(((s[1] >> 6) & 0x0F) | (s[2] << 4));
+    out[3] = (uint8_t)(((s[2] >> 4) & 0x3F) | (s[3] << 6));
+    out[4] = (uint8_t)(s[3] >> 2);
+}
+
+static inline void adcs_unpack4(uint16_t *s, const uint8_t *in)
+{
+    s[0] = (uint16_t)(in[0] | ((in[1] & 0x03) << 8));
+    s[1] = (uint16_t)((in[1] >> 2) | ((in[2] & 0x0F) << 6));
+    s[2] = (uint16_t)((in[2] >> 4) | ((in[3] & 0x3F) << 4));
+    s[3] = (uint16_t)((in[3] >> 6) | (in[4] << 2));
+}
+
+// Build a whole packet from ADCS_SAMPLES_PER_PACKET samples
+static inline void adcs_build(uint8_t *pkt, uint16_t seq, uint16_t rate, uint8_t channel, const uint16_t *samples)
+{
+    uint16_t crc;
+    uint8_t i;
+
+    pkt[0] = ADCS_SYNC0;
+    pkt[1] = ADCS_SYNC1;
+    pkt[ADCS_OFFSET_SEQ]      = (uint8_t)(seq);
+    pkt[ADCS_OFFSET_SEQ + 1]  = (uint8_t)(seq >> 8);
+    pkt[ADCS_OFFSET_RATE]     = (uint8_t)(rate);
+    pkt[ADCS_OFFSET_RATE + 1] = (uint8_t)(rate >> 8);
+    pkt[ADCS_OFFSET_CHANNEL]  = channel;
+    pkt[ADCS_OFFSET_COUNT]    = ADCS_SAMPLES_PER_PACKET;
+
+    for(i = 0; i < ADCS_SAMPLES_PER_PACKET/4; i++)
+    {
+        adcs_pack4(&pkt[ADCS_OFFSET_PAYLOAD + 5*i], &samples[4*i]);
+    }
+
+    crc = adcs_crc16(ADCS_CRC_INIT, &pkt[ADCS_OFFSET_SEQ], ADCS_OFFSET_CRC - ADCS_OFFSET_SEQ);
+    pkt[ADCS_OFFSET_CRC]     = (uint8_t)(crc);
+    pkt[ADCS_OFFSET_CRC + 1] = (uint8_t)(crc >> 8);
+}
+
+// 1 if the packet CRC holds
+static inline int adcs_check(const uint8_t *pkt)
+{
+    uint16_t crc = adcs_crc16(ADCS_CRC_INIT, &pkt[ADCS_OFFSET_SEQ], ADCS_OFFSET_CRC - ADCS_OFFSET_SEQ);
+
+    return (pkt[ADCS_OFFSET_CRC] == (uint8_t)crc) && (pkt[ADCS_OFFSET_CRC + 1] == (uint8_t)(crc >> 8));
+}
+
+#endif /* ADC_STREAM_H_ */
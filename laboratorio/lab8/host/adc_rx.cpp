@@ -0,0 +1,132 @@
+/*
+ * adc_rx.cpp
+ *
+ * Receive the binary ADC10 stream of lab8/main.c and write the samples to
+ * a file or a pipe.
+ *
+ *   adc_rx [-d /dev/ttyACM0] [-b 115200] [-o file|-] [-f text|raw] [-n samples] [-v vref]
+ *
+ * text: one "time_s code volts" line per sample.
+ * raw:  uint16_t little endian codes, for numpy.fromfile(dtype='<u2').
+ * Statistics go to stderr on exit (Ctrl+C or -n reached).
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <unistd.h>
+
+#include "adc_stream.hpp"
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int) { stop = 1; }
+
+static void usage(const char *argv0)
+{
+    std::fprintf(stderr,
+        "usage: %s [-d device] [-b baud] [-o file|-] [-f text|raw] [-n samples] [-v vref]\n", argv0);
+}
+
+int main(int argc, char **argv)
+{
+    std::string device = "/dev/ttyACM0";
+    std::string output = "-";
+    unsigned baud = 115200;
+    bool raw = false;
+    unsigned long long limit = 0;
+    double vref = 3.3;
+
+    int opt;
+    while((opt = getopt(argc, argv, "d:b:o:f:n:v:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'd': device = optarg; break;
+            case 'b': baud = (unsigned)std::strtoul(optarg, nullptr, 10); break;
+            case 'o': output = optarg; break;
+            case 'f':
+                if(!std::strcmp(optarg, "raw")) raw = true;
+                else if(std::strcmp(optarg, "text")) { usage(argv[0]); return 2; }
+                break;
+            case 'n': limit = std::strtoull(optarg, nullptr, 10); break;
+            case 'v': vref = std::strtod(optarg, nullptr); break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+
+    int fd = adcs::open_serial(device, baud);
+    if(fd < 0)
+    {
+        std::fprintf(stderr, "adc_rx: cannot open %s at %u baud: %s\n", device.c_str(), baud, std::strerror(errno));
+        return 1;
+    }
+
+    FILE *out = (output == "-") ? stdout : std::fopen(output.c_str(), raw ? "wb" : "w");
+    if(out == nullptr)
+    {
+        std::fprintf(stderr, "adc_rx: cannot open %s: %s\n", output.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;      // No SA_RESTART: read() returns EINTR
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    adcs::Decoder decoder;
+    unsigned long long written = 0;
+    uint8_t buf[512];
+
+    while(!stop && (limit == 0 || written < limit))
+    {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if(n < 0)
+        {
+            if(errno == EINTR) continue;
+            std::fprintf(stderr, "adc_rx: read: %s\n", std::strerror(errno));
+            break;
+        }
+        if(n == 0) break;
+
+        decoder.push(buf, (size_t)n, [&](const adcs::Packet &pkt)
+        {
+            // Time follows seq, so lost packets leave a gap instead of shifting the rest
+            const adcs::Stats &s = decoder.stats();
+            double ts = pkt.rate ? 1.0/pkt.rate : 0.0;
+            double t = (double)(s.packets + s.lost - 1)*ADCS_SAMPLES_PER_PACKET*ts;
+            for(int i = 0; i < pkt.count && (limit == 0 || written < limit); i++, written++)
+            {
+                if(raw)
+                {
+                    uint8_t le[2] = { (uint8_t)pkt.samples[i], (uint8_t)(pkt.samples[i] >> 8) };
+                    std::fwrite(le, 1, 2, out);
+                }
+                else
+                {
+                    std::fprintf(out, "%.6f %u %.4f\n", t, pkt.samples[i], pkt.samples[i]*vref/1023.0);
+                }
+                t += ts;
+            }
+            // A pipe reader (plot script) wants the samples now
+            std::fflush(out);
+        });
+        if(ferror(out)) break;      // Reader went away
+    }
+
+    const adcs::Stats &s = decoder.stats();
+    std::fprintf(stderr, "adc_rx: %llu packets, %llu samples, %llu lost, %llu crc errors, %llu bytes skipped\n",
+                 (unsigned long long)s.packets, (unsigned long long)s.samples, (unsigned long long)s.lost,
+                 (unsigned long long)s.crc_errors, (unsigned long long)s.skipped);
+
+    if(out != stdout) std::fclose(out);
+    close(fd);
+
+    return 0;
+}
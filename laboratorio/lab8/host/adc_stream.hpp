@@ -0,0 +1,147 @@
+/*
+ * adc_stream.hpp
+ *
+ * Linux side of the ADC10 stream (see ../adc_stream.h): serial port setup
+ * and a decoder that resynchronizes on the sync bytes and the CRC.
+ */
+
+#ifndef ADC_STREAM_HPP_
+#define ADC_STREAM_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "../adc_stream.h"
+
+namespace adcs {
+
+struct Packet
+{
+    uint16_t seq;
+    uint16_t rate;
+    uint8_t channel;
+    uint8_t count;
+    uint16_t samples[ADCS_SAMPLES_PER_PACKET];
+};
+
+struct Stats
+{
+    uint64_t packets = 0;       // Packets with a good CRC
+    uint64_t samples = 0;
+    uint64_t crc_errors = 0;    // Sync found but the CRC failed
+    uint64_t lost = 0;          // Packets missing from the seq numbering
+    uint64_t skipped = 0;       // Bytes thrown away while hunting for sync
+};
+
+class Decoder
+{
+public:
+    // Feed raw bytes, on_packet(const Packet &) runs for every good packet
+    template <typename F>
+    void push(const uint8_t *data, size_t len, F &&on_packet)
+    {
+        buf_.insert(buf_.end(), data, data + len);
+
+        size_t pos = 0;
+        while(buf_.size() - pos >= ADCS_PACKET_SIZE)
+        {
+            const uint8_t *p = &buf_[pos];
+            if(p[0] != ADCS_SYNC0 || p[1] != ADCS_SYNC1)
+            {
+                pos++;
+                stats_.skipped++;
+                continue;
+            }
+            if(!adcs_check(p) || p[ADCS_OFFSET_COUNT] > ADCS_SAMPLES_PER_PACKET)
+            {
+                // Sync bytes inside the payload or a damaged packet: slide by one
+                stats_.crc_errors++;
+                pos++;
+                continue;
+            }
+
+            Packet pkt;
+            pkt.seq = (uint16_t)(p[ADCS_OFFSET_SEQ] | (p[ADCS_OFFSET_SEQ + 1] << 8));
+            pkt.rate = (uint16_t)(p[ADCS_OFFSET_RATE] | (p[ADCS_OFFSET_RATE + 1] << 8));
+            pkt.channel = p[ADCS_OFFSET_CHANNEL];
+            pkt.count = p[ADCS_OFFSET_COUNT];
+            for(int i = 0; i < ADCS_SAMPLES_PER_PACKET/4; i++)
+            {
+                adcs_unpack4(&pkt.samples[4*i], &p[ADCS_OFFSET_PAYLOAD + 5*i]);
+            }
+
+            if(have_seq_) stats_.lost += (uint16_t)(pkt.seq - last_seq_ - 1);
+            have_seq_ = true;
+            last_seq_ = pkt.seq;
+            stats_.packets++;
+            stats_.samples += pkt.count;
+
+            on_packet(pkt);
+            pos += ADCS_PACKET_SIZE;
+        }
+
+        buf_.erase(buf_.begin(), buf_.begin() + pos);
+    }
+
+    const Stats &stats() const { return stats_; }
+
+private:
+    std::vector<uint8_t> buf_;
+    Stats stats_;
+    bool have_seq_ = false;
+    uint16_t last_seq_ = 0;
+};
+
+// Raw 8N1 serial port, -1 on error. Works on pseudo-terminals too.
+inline int open_serial(const std::string &path, unsigned baud)
+{
+    speed_t speed;
+    switch(baud)
+    {
+        case 9600:   speed = B9600;   break;
+        case 19200:  speed = B19200;  break;
+        case 38400:  speed = B38400;  break;
+        case 57600:  speed = B57600;  break;
+        case 115200: speed = B115200; break;
+        case 230400: speed = B230400; break;
+        case 460800: speed = B460800; break;
+        case 921600: speed = B921600; break;
+        default: return -1;
+    }
+
+    int fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if(fd < 0) return -1;
+
+    struct termios tio;
+    if(tcgetattr(fd, &tio) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if(tcsetattr(fd, TCSANOW, &tio) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    tcflush(fd, TCIFLUSH);
+
+    return fd;
+}
+
+} // namespace adcs
+
+#endif /* ADC_STREAM_HPP_ */
@@ -0,0 +1,205 @@
+/*
+ * loopback_test.cpp
+ *
+ * End to end check of the ADC10 stream through a pseudo-terminal. A writer
+ * thread plays the MSP430: it builds packets with adc_stream.h and paces
+ * them at the sample rate, never faster than the UART would carry them
+ * (baud/10 bytes/s). It also damages some packets, drops others and adds
+ * line noise. The main thread reads the slave side with the same serial
+ * setup and decoder as adc_rx.
+ *
+ *   loopback_test [-r rate_hz] [-b baud] [-s seconds]
+ *
+ * Exit status 0 when every good packet arrives intact, every bad or dropped
+ * one is counted as lost, and the link kept up with the sample rate.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "adc_stream.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static const unsigned CORRUPT_EVERY = 50;   // Flip a payload bit
+static const unsigned DROP_EVERY = 73;      // Firmware overrun: seq skipped
+static const unsigned NOISE_EVERY = 31;     // Stray bytes (with a fake sync) between packets
+
+// Test signal, a function of the absolute sample index
+static uint16_t signal_at(uint64_t k, unsigned rate)
+{
+    double v = 511.5 + 500.0*std::sin(2.0*M_PI*50.0*(double)k/rate);
+
+    return (uint16_t)std::lround(v) & 0x3FF;
+}
+
+static bool write_all(int fd, const uint8_t *p, size_t n)
+{
+    while(n)
+    {
+        ssize_t w = write(fd, p, n);
+        if(w < 0) return false;
+        p += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned rate = 7000;
+    unsigned baud = 115200;
+    double seconds = 3.0;
+
+    int opt;
+    while((opt = getopt(argc, argv, "r:b:s:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'r': rate = (unsigned)std::strtoul(optarg, nullptr, 10); break;
+            case 'b': baud = (unsigned)std::strtoul(optarg, nullptr, 10); break;
+            case 's': seconds = std::strtod(optarg, nullptr); break;
+            default:
+                std::fprintf(stderr, "usage: %s [-r rate_hz] [-b baud] [-s seconds]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    const unsigned npackets = (unsigned)(seconds*rate/ADCS_SAMPLES_PER_PACKET);
+    const double link_bytes_per_s = baud/10.0;  // 8N1
+
+    // Pseudo-terminal pair
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if(master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        std::perror("loopback_test: posix_openpt");
+        return 1;
+    }
+    std::string slave_path = ptsname(master);
+    int slave = adcs::open_serial(slave_path, baud);
+    if(slave < 0)
+    {
+        std::perror("loopback_test: open slave");
+        return 1;
+    }
+
+    std::atomic<bool> writer_done(false);
+    unsigned corrupted = 0, dropped = 0;
+
+    Clock::time_point start = Clock::now();
+    std::thread writer([&]
+    {
+        uint8_t pkt[ADCS_PACKET_SIZE];
+        uint16_t samples[ADCS_SAMPLES_PER_PACKET];
+        const uint8_t noise[] = { 0x00, ADCS_SYNC0, ADCS_SYNC1, 0x13 };
+        double wire_time = 0.0;     // Link busy until this time (s)
+
+        for(unsigned seq = 0; seq < npackets; seq++)
+        {
+            // The packet exists once its last sample is converted
+            double ready = (double)(seq + 1)*ADCS_SAMPLES_PER_PACKET/rate;
+            if(wire_time < ready) wire_time = ready;
+
+            // The last packet stays intact, a loss is only seen as a gap before a good one
+            bool last = (seq == npackets - 1);
+            if(!last && seq % DROP_EVERY == DROP_EVERY - 1)
+            {
+                dropped++;
+                continue;
+            }
+
+            for(int i = 0; i < ADCS_SAMPLES_PER_PACKET; i++)
+            {
+                samples[i] = signal_at((uint64_t)seq*ADCS_SAMPLES_PER_PACKET + i, rate);
+            }
+            adcs_build(pkt, (uint16_t)seq, (uint16_t)rate, 5, samples);
+            if(!last && seq % CORRUPT_EVERY == CORRUPT_EVERY - 1)
+            {
+                pkt[ADCS_OFFSET_PAYLOAD + seq % ADCS_PAYLOAD_SIZE] ^= 0x04;
+                corrupted++;
+            }
+
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(wire_time)));
+            if(!write_all(master, pkt, sizeof(pkt))) break;
+            wire_time += sizeof(pkt)/link_bytes_per_s;
+
+            if(seq % NOISE_EVERY == NOISE_EVERY - 1)
+            {
+                if(!write_all(master, noise, sizeof(noise))) break;
+                wire_time += sizeof(noise)/link_bytes_per_s;
+            }
+        }
+        writer_done = true;
+    });
+
+    // Reader: same path as adc_rx
+    adcs::Decoder decoder;
+    unsigned long long mismatches = 0;
+    Clock::time_point last_rx = start;
+    uint8_t buf[512];
+    while(true)
+    {
+        struct pollfd pfd = { slave, POLLIN, 0 };
+        int r = poll(&pfd, 1, 200);
+        if(r == 0)
+        {
+            if(writer_done) break;
+            continue;
+        }
+        if(r < 0) break;
+
+        ssize_t n = read(slave, buf, sizeof(buf));
+        if(n <= 0) break;
+        decoder.push(buf, (size_t)n, [&](const adcs::Packet &pkt)
+        {
+            for(int i = 0; i < pkt.count; i++)
+            {
+                if(pkt.samples[i] != signal_at((uint64_t)pkt.seq*ADCS_SAMPLES_PER_PACKET + i, rate)) mismatches++;
+            }
+            last_rx = Clock::now();
+        });
+    }
+    writer.join();
+    double elapsed = std::chrono::duration<double>(last_rx - start).count();
+
+    const adcs::Stats &s = decoder.stats();
+    unsigned long long expect_good = npackets - corrupted - dropped;
+    unsigned long long expect_lost = corrupted + dropped;
+    double airtime = ADCS_PACKET_SIZE/link_bytes_per_s;
+    double period = (double)ADCS_SAMPLES_PER_PACKET/rate;
+    double ideal = (double)npackets*ADCS_SAMPLES_PER_PACKET/rate;
+
+    std::printf("rate %u Hz over %u baud: %u packets in %.3f s (ideal %.3f s)\n", rate, baud, npackets, elapsed, ideal);
+    std::printf("link load %.1f %% (binary), %.1f %% if sent as \"1023\\r\\n\" ASCII\n",
+                100.0*airtime/period, 100.0*6.0*rate/link_bytes_per_s);
+    std::printf("received %llu/%llu good packets, lost %llu/%llu, crc errors %llu, skipped %llu bytes, %llu bad samples\n",
+                (unsigned long long)s.packets, expect_good, (unsigned long long)s.lost, expect_lost,
+                (unsigned long long)s.crc_errors, (unsigned long long)s.skipped, mismatches);
+
+    bool ok = true;
+    if(s.packets != expect_good || s.lost != expect_lost || mismatches != 0)
+    {
+        std::printf("FAIL: stream not decoded exactly\n");
+        ok = false;
+    }
+    if(airtime > period || elapsed > ideal*1.05 + 0.05)
+    {
+        std::printf("FAIL: %u baud cannot sustain %u samples/s\n", baud, rate);
+        ok = false;
+    }
+    if(ok) std::printf("PASS\n");
+
+    close(slave);
+    close(master);
+
+    return ok ? 0 : 1;
+}
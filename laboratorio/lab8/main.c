@@ -0,0 +1,137 @@
+#include <msp430.h>
+#include <stdint.h>
+#include "adc_stream.h"
+
+/* Defines -----------------------*/
+// BOARD defines
+#define LED_RED     BIT0
+#define LED_GREEN   BIT6
+#define UART_RXD    BIT1
+#define UART_TXD    BIT2
+#define CPU_F       (16000000UL)
+// ADC defines
+#define ADC_CHANNEL     (5)         // A5 on P1.5 (A1/A2 pins are the UART)
+#define SAMPLE_RATE_HZ  (6400U)     // 87% of the 115200 baud link (7372 samples/s max)
+#define TIMER_PERIOD    (CPU_F/SAMPLE_RATE_HZ)
+
+/* Global variables --------------*/
+// ADC samples, the ISR fills one half while the main loop sends the other
+static uint16_t uiSamples[2][ADCS_SAMPLES_PER_PACKET];
+static volatile uint8_t ucFill = 0;         // Half written by the ISR
+static volatile uint8_t ucIndex = 0;        // Next sample in that half
+static volatile uint8_t ucReady = 0;        // 1 when the other half is complete
+static volatile uint16_t uiSeq = 0;         // Counts every half the ISR completes
+static volatile uint16_t uiReadySeq = 0;    // seq of the complete half
+
+static uint8_t ucPacket[ADCS_PACKET_SIZE];
+
+/* Private prototype function ----*/
+static void vUartSend(const uint8_t *pucData, uint8_t ucLen);
+
+/**
+ * main.c
+ *
+ * @brief   Stream ADC10 samples over the UART in the binary format of
+ *          adc_stream.h. TA0.1 triggers the conversions at SAMPLE_RATE_HZ,
+ *          the ADC10 ISR stores them, the main loop packs and sends a
+ *          packet every ADCS_SAMPLES_PER_PACKET samples.
+ */
+void main(void)
+{
+    uint8_t ucHalf;
+    uint16_t uiSeqOut;
+
+    /* WDT */
+    WDTCTL = WDTPW | WDTHOLD;   // stop watchdog timer
+
+    /* BCM Clock Module */
+    BCSCTL1 = CALBC1_16MHZ;     // 16MHz
+    DCOCTL = CALDCO_16MHZ;      // 16MHz
+
+    /* GPIO */
+    P1OUT = 0x00;
+    P1DIR |= LED_RED | LED_GREEN;
+    P1SEL = UART_RXD | UART_TXD;    // USCI_A0 RXD/TXD
+    P1SEL2 = UART_RXD | UART_TXD;
+
+    /* UART 115200 8N1 (SMCLK = 16MHz: N = 138.89, UCBR = 138, UCBRS = 7) */
+    UCA0CTL1 = UCSWRST | UCSSEL_2;
+    UCA0BR0 = 138;
+    UCA0BR1 = 0;
+    UCA0MCTL = UCBRS_7;
+    UCA0CTL1 &= ~UCSWRST;
+
+    /* ADC */
+    ADC10CTL1 = (ADC_CHANNEL << 12) | SHS_1 | CONSEQ_2; // TA0.1 trigger, repeat single channel
+    ADC10CTL0 = SREF_0 | ADC10SHT_2 | ADC10ON | ADC10IE; // VR+ = VCC, VR- = VSS
+    ADC10AE0 |= (1 << ADC_CHANNEL);
+    ADC10CTL0 |= ENC;
+
+    /* TIMER TA0: one SHI rising edge per sample period */
+    TA0CCR0 = TIMER_PERIOD - 1;
+    TA0CCR1 = TIMER_PERIOD/2;
+    TA0CCTL1 = OUTMOD_3;            // Set at CCR1, reset at CCR0
+    TA0CTL = TASSEL_2 | MC_1;       // SMCLK, UP mode
+
+    /* Global Interrupts */
+    __enable_interrupt();
+
+    /* Super-loop */
+    while(1)
+    {
+        __disable_interrupt();
+        if(!ucReady)
+        {
+            // Sleep until the ISR completes a half (sets GIE atomically)
+            __bis_SR_register(LPM0_bits | GIE);
+            continue;
+        }
+        ucHalf = ucFill ^ 1;
+        uiSeqOut = uiReadySeq;
+        __enable_interrupt();
+
+        adcs_build(ucPacket, uiSeqOut, SAMPLE_RATE_HZ, ADC_CHANNEL, uiSamples[ucHalf]);
+
+        // The half is free once packed: a late main loop loses whole packets,
+        // the receiver sees it as a gap in seq
+        ucReady = 0;
+
+        P1OUT |= LED_GREEN;
+        vUartSend(ucPacket, ADCS_PACKET_SIZE);
+        P1OUT &= ~LED_GREEN;
+    }
+}
+
+
+/* Interrupt service routine ---------------------*/
+#pragma vector=ADC10_VECTOR
+__interrupt void ADC10_ISR(void)
+{
+    uiSamples[ucFill][ucIndex] = ADC10MEM;
+    if(++ucIndex < ADCS_SAMPLES_PER_PACKET) return;
+
+    // Half complete
+    ucIndex = 0;
+    if(ucReady)
+    {
+        // Main loop still packing the other half, this one is overwritten
+        uiSeq++;
+        P1OUT |= LED_RED;
+        return;
+    }
+    uiReadySeq = uiSeq++;
+    ucFill ^= 1;
+    ucReady = 1;
+    __bic_SR_register_on_exit(LPM0_bits);
+}
+
+
+/* Private reference function --------------------*/
+static void vUartSend(const uint8_t *pucData, uint8_t ucLen)
+{
+    while(ucLen--)
+    {
+        while(!(IFG2 & UCA0TXIFG));
+        UCA0TXBUF = *pucData++;
+    }
+}
@@ -1,74 +1,66 @@
+import sys
+import threading
+import collections
 import matplotlib.pyplot as plt
 import matplotlib.animation as animation
-import serial
-import numpy as np
 
+# Uso: ./host/adc_rx -d /dev/ttyACM0 | python3 script.py
+# adc_rx decodifica el stream binario y escribe "tiempo codigo voltaje" por linea
 
-# Configurar y abrir el puerto serial
+Tplot = 50      # Tiempo de actualizar grafica (ms)
+Nplot = 1280    # Numero de muestras maximas a graficar (0.2 s a 6400 Hz)
+Vmin = 0.0      # Voltaje minimo del ADC
+Vmax = 3.3      # Voltaje maximo del ADC
 
-# Verificar que el puerto se abrio correctamente
+# Ultimas Nplot muestras, las llena el hilo lector
+t = collections.deque(maxlen=Nplot)        # Vector de tiempo
+samples = collections.deque(maxlen=Nplot)  # Vector de voltaje
+lock = threading.Lock()
+
+# Hilo que lee las muestras de adc_rx por stdin
+def reader():
+    for line in sys.stdin:
+        fields = line.split()
+        if len(fields) != 3:
+            continue
+        with lock:
+            t.append(float(fields[0]))
+            samples.append(float(fields[2]))
+    print('#Serial: Fin del stream')
 
 # Evento que se ejecuta cuando se cierra la grafica
 def handle_close(evt):
     print('#Serial: Puerto cerrado')
-    
+    sys.exit(0)
+
 # Figura donde se va a graficar los datos
 fig = plt.figure()
 ax = fig.add_subplot(1, 1, 1)
 # Conectar una función que se ejecutara cuando se cierre la grafica
 fig.canvas.mpl_connect('close_event', handle_close)
-t = []       # Vector de tiempo
-samples = [] # Vector de voltaje
-
-Tplot = 20  # Tiempo de actualizar grafica (ms)
-Fs = 100    # Frecuencia de muestreo (Hz)
-Ts = 1/Fs   # Periodo de muestreo
-Nplot = 30  # Numero de muestras maximas a graficar (N*Ts > Tplot)
-Vmin = -1.0 # Voltaje maximo del ADC
-Vmax = 1.0  # Voltaje minimo del ADC
-first_plot = True
 
 # This function is called periodically from FuncAnimation
-def animate(n, t, samples, Ts, N):
-    global first_plot
-    
-    # Dato a graficar
-	sample = np.sin(np.pi/5 * n)
-    
-	# Añadir las muestras a las listas
-    t.append(n)
-    samples.append(sample)
-    
-    # Eliminar las muestras pasadas cuando len(samples) > Nplot
-    # Y establecer el eje de tiempo min y max
-    if first_plot:
-        if len(t) < N:
-            tmin = 0
-            tmax = None
-        else:
-            first_plot = False
-            tmin=t[0]
-            tmax=t[-1]
-    else:        
-        
-        if len(t)>N:
-            t=t[len(t)-N:len(t)]
-            samples=samples[len(samples)-N:len(samples)]    
-        tmin = t[0]
-        tmax = t[-1]
-            
+def animate(n):
+    with lock:
+        if not t:
+            return
+        tt = list(t)
+        vv = list(samples)
+
     # Graficar samples vs t
     ax.clear()
-    ax.plot(t, samples)
+    ax.plot(tt, vv)
 
     # Format plot
     plt.xticks(rotation=45, ha='right')
     plt.subplots_adjust(bottom=0.30)
-    plt.ylabel('Tiempo (s)')
+    plt.xlabel('Tiempo (s)')
     plt.ylabel('Voltaje (V)')
-    plt.axis([tmin, tmax, Vmin, Vmax])
+    plt.axis([tt[0], max(tt[-1], tt[0] + 1e-3), Vmin, Vmax])
+
 
+threading.Thread(target=reader, daemon=True).start()
 
 # Habilitar grafica
-ani = animation.FuncAnimation(fig, animate, fargs=(t, samples, Ts, N), interval=Tplot)
-fig.show()
+ani = animation.FuncAnimation(fig, animate, interval=Tplot, cache_frame_data=False)
+plt.show()
@@ -0,0 +1,117 @@
+/**
+  ******************************************************************************
+  * @file       msp430_hal_frame.h
+  * @author     Fernando Hermosillo Reynoso
+  * @brief      Header file of the UART packet framing (COBS/SLIP) HAL module.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 Universidad Panamericana.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DRIVERS_MSP430_HAL_FRAME_H_
+#define DRIVERS_MSP430_HAL_FRAME_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <Drivers/msp430x2xx.h>
+#include <Drivers/msp430_hal_uart.h>
+
+#ifndef configHAL_FRAME_MAX_LENGTH
+#define configHAL_FRAME_MAX_LENGTH  (32)    // Decoded bytes per packet, CRC included
+#endif
+#ifndef configHAL_FRAME_POOL_SIZE
+#define configHAL_FRAME_POOL_SIZE   (2)     // Packets (2..8)
+#endif
+
+/** @addtogroup MSP430X2XX_HAL_Driver
+ * @{
+ */
+
+/** @addtogroup FRAME
+ * @{
+ */
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+    uint16_t Length;                            /**< Payload length (CRC removed) */
+    uint8_t Data[configHAL_FRAME_MAX_LENGTH];   /**< Payload */
+} FRAME_PacketTypeDef;
+
+/**
+ * @brief Packet link over a buffered UART. The RX interrupt decodes the
+ *        frames into a packet of the pool and checks the CRC, complete
+ *        packets are handed to the task by pointer (no copy).
+ */
+typedef struct
+{
+    UART_BufHandleTypeDef *hbuf;        /**< UART, the frame layer takes its RX bytes */
+    uint8_t Mode;                       /**< FRAME_MODE_COBS or FRAME_MODE_SLIP */
+
+    FRAME_PacketTypeDef Pool[configHAL_FRAME_POOL_SIZE];
+    volatile uint8_t FreeMask;          /**< Bit n set while Pool[n] is free */
+    uint8_t Ready[8];                   /**< Indexes of the complete packets, in arrival order */
+    volatile uint8_t ReadyHead;         /**< Written by the RX interrupt */
+    volatile uint8_t ReadyTail;         /**< Written by HAL_FRAME_Receive */
+
+    // Decoder (RX interrupt)
+    FRAME_PacketTypeDef *RxPacket;      /**< Packet being decoded, NULL if none */
+    uint16_t RxLength;
+    uint16_t RxCrc;
+    uint8_t RxCode;                     /**< COBS: code of the current block */
+    uint8_t RxLeft;                     /**< COBS: bytes left in the block, SLIP: escape pending */
+    uint8_t RxState;
+
+    // Statistics
+    volatile uint16_t CrcErrors;        /**< Frames with a wrong CRC or encoding */
+    volatile uint16_t Overflows;        /**< Frames longer than configHAL_FRAME_MAX_LENGTH */
+    volatile uint16_t Dropped;          /**< Frames lost because the pool was empty */
+
+#if HAL_UART_USE_BLOCKING == (1)
+    volatile TaskHandle_t RxWaiter;     /**< Task waiting in HAL_FRAME_Receive_Blocking */
+#endif
+} FRAME_HandleTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+#define FRAME_MODE_COBS     (0x00)
+#define FRAME_MODE_SLIP     (0x01)
+
+#define FRAME_CRC_SIZE      (2)         // CRC-16/CCITT-FALSE, most significant byte first
+#define FRAME_CRC16_INIT    (0xFFFF)
+
+/* Exported macro ------------------------------------------------------------*/
+#define IS_FRAME_MODE(MODE)     ( ((MODE) == FRAME_MODE_COBS) || ((MODE) == FRAME_MODE_SLIP) )
+
+/* Exported functions --------------------------------------------------------*/
+uint16_t HAL_FRAME_Init(FRAME_HandleTypeDef *hframe, UART_BufHandleTypeDef *hbuf, uint8_t Mode);
+uint16_t HAL_FRAME_Send(FRAME_HandleTypeDef *hframe, const uint8_t *pData, uint16_t len);
+uint16_t HAL_FRAME_Receive(FRAME_HandleTypeDef *hframe, FRAME_PacketTypeDef **ppPacket);
+uint16_t HAL_FRAME_Release(FRAME_HandleTypeDef *hframe, FRAME_PacketTypeDef *pPacket);
+#if HAL_UART_USE_BLOCKING == (1)
+uint16_t HAL_FRAME_Receive_Blocking(FRAME_HandleTypeDef *hframe, FRAME_PacketTypeDef **ppPacket, TickType_t Timeout);
+#endif
+uint16_t HAL_FRAME_Crc16(uint16_t crc, const uint8_t *pData, uint16_t len);
+
+/* Private types -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private constants ---------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVERS_MSP430_HAL_FRAME_H_ */
@@ -72,12 +72,17 @@ typedef struct
     volatile uint8_t TxCount;
     volatile uint8_t *RxBuffer;
     volatile uint8_t RxCount;
+    uint8_t Reg;                        // Register address, sent before TxBuffer
+    volatile uint8_t RegCount;          // 1 while Reg is still to be sent
 
-    void(*TxCpltCallback)(void *hi2c);
-    void(*RxCpltCallback)(void *hi2c);
-    void(*ErrorCallback)(void *hi2c);
+    // Callbacks (__HAL_USCI_CALLBACK), set before the transfer, may be NULL
+    void(*TxCpltCallback)(void *hi2c);  // Write only transfer done (STOP sent)
+    void(*RxCpltCallback)(void *hi2c);  // Last byte read
+    void(*ErrorCallback)(void *hi2c);   // NACK or arbitration lost, see ErrorCode
+    void(*XferEnd)(void *hi2c, uint8_t FromISR);    // Every end of transfer, before the callbacks (I2CBUS). FromISR 0 in the deferred call daemon
 
-    uint8_t State;
+    volatile uint8_t State;             // I2C_STATE_xxx
+    volatile uint8_t ErrorCode;         // I2C_ERROR_xxx of the last transfer
     HAL_BaseTypeDef Lock;
 } I2C_HandleTypeDef;
 
@@ -100,6 +105,14 @@ typedef struct
 #define I2C_ERROR_BUSY      (4)
 #define I2C_ERROR_IDLE      (5)
 #define I2C_ERROR_ARGIN     (6)
+#define I2C_ERROR_ARLO      (7)     // Arbitration lost
+// Interrupt driven transfer state (State)
+#define I2C_STATE_IDLE      (0)
+#define I2C_STATE_NACK      (1)
+#define I2C_STATE_TX        (2)
+#define I2C_STATE_RX        (3)
+#define I2C_STATE_TIMEOUT   (4)
+#define I2C_STATE_STOP      (5)     // STOP going out, the transfer ends after it
 // Clocks
 #define I2C_CLKSRC_UCLK    (0)
 #define I2C_CLKSRC_ACLK    (1)
@@ -191,9 +204,37 @@ uint16_t HAL_I2C_Transfer(I2C_TypeDef *I2Cx, I2C_MessageTypeDef *I2C_MessageStru
 
 uint16_t HAL_I2C_Alloc_ISR(I2C_HandleTypeDef *hi2c);
 uint16_t HAL_I2C_Free_ISR(I2C_HandleTypeDef *hi2c);
+
+ /*
+  * @name    HAL_I2C_Transmit_IT, HAL_I2C_TransmitReceive_IT
+  * @brief   Start a transfer driven by the USCI interrupts (HAL_I2C_Alloc_ISR):
+  *          write TxCount bytes, then a repeated start and read RxCount bytes
+  *          (TransmitReceive). Either part may be empty, not both. The
+  *          handle callbacks report the end of the transfer.
+  *
+  * @return  I2C error {I2C_ERROR_NONE, I2C_ERROR_BUSY, I2C_ERROR_OVADR, I2C_ERROR_ARGIN}
+  * @require HAL_I2C_Alloc_ISR
+  */
 uint16_t HAL_I2C_Transmit_IT(I2C_HandleTypeDef *hi2c, I2C_MessageTypeDef *I2C_Message);
 uint16_t HAL_I2C_TransmitReceive_IT(I2C_HandleTypeDef *hi2c, I2C_MessageTypeDef *I2C_Message);
 
+ /*
+  * @name    HAL_I2C_Read_Regs_IT, HAL_I2C_Write_Regs_IT
+  * @brief   Register access without waiting: START, address, RegAddress, then a
+  *          repeated start and len bytes read, or len bytes written, STOP
+  *
+  * @return  I2C error {I2C_ERROR_NONE, I2C_ERROR_BUSY, I2C_ERROR_ARGIN}
+  * @require HAL_I2C_Alloc_ISR
+  */
+uint16_t HAL_I2C_Read_Regs_IT(I2C_HandleTypeDef *hi2c, uint8_t Address, uint8_t RegAddress, uint8_t *RegData, uint8_t len);
+uint16_t HAL_I2C_Write_Regs_IT(I2C_HandleTypeDef *hi2c, uint8_t Address, uint8_t RegAddress, const uint8_t *RegData, uint8_t len);
+
+ /*
+  * @name    HAL_I2C_IsIdle
+  * @return  1 when no interrupt driven transfer is running
+  */
+uint8_t HAL_I2C_IsIdle(I2C_HandleTypeDef *hi2c);
+
 /* Private types -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 /* Private constants ---------------------------------------------------------*/
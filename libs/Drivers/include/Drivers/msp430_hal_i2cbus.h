@@ -0,0 +1,121 @@
+/**
+  ******************************************************************************
+  * @file       msp430_hal_i2cbus.h
+  * @author     Fernando Hermosillo Reynoso
+  * @brief      Header file of the shared I2C bus (transaction scheduler) HAL
+  *             module.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 Universidad Panamericana.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DRIVERS_MSP430_HAL_I2CBUS_H_
+#define DRIVERS_MSP430_HAL_I2CBUS_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <Drivers/msp430x2xx.h>
+#include <Drivers/msp430_hal_i2c.h>
+#if configHAL_USE_UPRTOS == (1)
+#include <UpRTOS/UpTask.h>
+#endif
+
+// Requester tasks sleep on a notification (HAL_I2CBUS_Transfer)
+#if configHAL_USE_UPRTOS == (1) && configUSE_NOTIFICATIONS == (1)
+#define HAL_I2CBUS_USE_NOTIFY   (1)
+#else
+#define HAL_I2CBUS_USE_NOTIFY   (0)
+#endif
+#ifndef configHAL_I2CBUS_NOTIFY_INDEX
+#define configHAL_I2CBUS_NOTIFY_INDEX   (0)     // Notification index given on completion
+#endif
+
+/** @addtogroup MSP430X2XX_HAL_Driver
+ * @{
+ */
+
+/** @addtogroup I2CBUS
+ * @{
+ */
+
+/* Exported types ------------------------------------------------------------*/
+struct __I2CBUS_TransactionTypeDef;
+typedef void(* I2CBUSCallback_t)(struct __I2CBUS_TransactionTypeDef *);
+
+/**
+ * @brief One START..STOP transfer with a device: [Reg] [pTxData], then
+ *        pRxData after a repeated start. Owned by the caller until Status
+ *        leaves I2CBUS_PENDING.
+ */
+typedef struct __I2CBUS_TransactionTypeDef
+{
+    uint16_t DevAddress;
+    uint8_t Reg;                        /**< Register address, sent first with I2CBUS_FLAG_REG */
+    uint8_t Flags;                      /**< I2CBUS_FLAG_xxx */
+    const uint8_t *pTxData;
+    uint8_t TxSize;                     /**< 0 with I2CBUS_FLAG_REG and RxSize (register read) */
+    uint8_t *pRxData;
+    uint8_t RxSize;
+    volatile uint8_t Status;            /**< I2CBUS_IDLE, I2CBUS_PENDING, I2CBUS_DONE or I2CBUS_ERROR */
+    uint8_t ErrorCode;                  /**< I2C_ERROR_xxx */
+    I2CBUSCallback_t Callback;          /**< Called on completion (__HAL_USCI_CALLBACK), may be NULL */
+    void *Arg;                          /**< For the callback */
+#if HAL_I2CBUS_USE_NOTIFY == (1)
+    volatile TaskHandle_t Task;         /**< Notified on completion, may be NULL */
+#endif
+    struct __I2CBUS_TransactionTypeDef *Next;   /**< Queue link */
+} I2CBUS_TransactionTypeDef;
+
+typedef struct
+{
+    I2C_HandleTypeDef hi2c;             /**< Interrupt driven engine, owned by the bus */
+
+    I2CBUS_TransactionTypeDef *volatile Head;   /**< Transaction on the bus, NULL when idle */
+    I2CBUS_TransactionTypeDef *Tail;
+} I2CBUS_HandleTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+// Transaction status
+#define I2CBUS_IDLE         (0x00)
+#define I2CBUS_PENDING      (0x01)      // Queued or on the bus
+#define I2CBUS_DONE         (0x02)
+#define I2CBUS_ERROR        (0x03)      // See ErrorCode
+
+// Transaction flags
+#define I2CBUS_FLAG_REG     (0x01)      // Send Reg before pTxData/pRxData
+
+/* Exported macro ------------------------------------------------------------*/
+#define __HAL_I2CBUS_IS_DONE(__XFER__)  ( (__XFER__)->Status >= I2CBUS_DONE )
+
+/* Exported functions --------------------------------------------------------*/
+uint16_t HAL_I2CBUS_Init(I2CBUS_HandleTypeDef *hbus, I2C_TypeDef *I2Cx);
+uint16_t HAL_I2CBUS_Submit(I2CBUS_HandleTypeDef *hbus, I2CBUS_TransactionTypeDef *xfer);
+uint16_t HAL_I2CBUS_SubmitFromISR(I2CBUS_HandleTypeDef *hbus, I2CBUS_TransactionTypeDef *xfer);
+uint8_t HAL_I2CBUS_IsIdle(I2CBUS_HandleTypeDef *hbus);
+#if HAL_I2CBUS_USE_NOTIFY == (1)
+uint16_t HAL_I2CBUS_Transfer(I2CBUS_HandleTypeDef *hbus, I2CBUS_TransactionTypeDef *xfer, TickType_t Timeout);
+#endif
+
+/* Private types -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private constants ---------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVERS_MSP430_HAL_I2CBUS_H_ */
@@ -27,6 +27,22 @@
 /* Includes ------------------------------------------------------------------*/
 #include <Drivers/msp430x2xx.h>
 #include <Drivers/msp430_hal_usci.h>
+#if configHAL_USE_UPRTOS == (1)
+#include <UpRTOS/UpTask.h>
+#endif
+
+// Blocking interrupt-driven calls, the task sleeps on a notification
+#if configHAL_USE_UPRTOS == (1) && configUSE_NOTIFICATIONS == (1)
+#define HAL_SPI_USE_BLOCKING    (1)
+#else
+#define HAL_SPI_USE_BLOCKING    (0)
+#endif
+#ifndef configHAL_SPI_NOTIFY_INDEX
+#define configHAL_SPI_NOTIFY_INDEX      (0)     // Notification index used by the blocking calls
+#endif
+#ifndef configHAL_SPI_MASK_CYCLES
+#define configHAL_SPI_MASK_CYCLES       (128)   // Longest interrupt-masked group of the block transfer, in BRCLK cycles
+#endif
 
 /** @addtogroup MSP430X2XX_HAL_Driver
  * @{
@@ -92,9 +108,13 @@
      uint8_t CS_Pin;
      __IO uint8_t *CS_Port;
 
+#if HAL_SPI_USE_BLOCKING == (1)
+     volatile TaskHandle_t Waiter;  // Task sleeping in HAL_SPI_TransmitReceive_Blocking
+#endif
 
      // Flags
      HAL_BaseTypeDef Lock;
+     volatile uint8_t Duplex;       // 1 while a HAL_SPI_TransmitReceive_IT transfer runs
  } SPI_HandleTypeDef;
 
  typedef void(*SPI_CallbackTypeDef)(SPI_HandleTypeDef *hspi);
@@ -149,6 +169,9 @@
 #define SPI_CS_HIGH (0x01)
 #define IS_SPI_CS   (((CSCON) == SPI_CS_LOW) || \
                     ((CSCON) == SPI_CS_HIGH))
+// Block transfer
+#define SPI_DUMMY_BYTE      (0xFF)  // Sent by the block transfer when there is no TX data
+#define SPI_BLOCK_UNROLL    (4)     // Bytes per loop of the transmit only block transfer
 
 // Interrupts (TODO: should it be in the msp430g2x5x?)
 #define SPI0_TXIE   UCA0TXIE
@@ -167,10 +190,11 @@
 #define __HAL_SPI_DISABLE_TX_IT(__HANDLE__)    IE2 &= ~(__HANDLE__->Instance == SPI1 ? UCA0TXIE : UCB0TXIE)
 #define __HAL_SPI_ENABLE_RX_IT(__HANDLE__)     IE2 |= (__HANDLE__->Instance == SPI1 ? UCA0RXIE : UCB0RXIE)
 #define __HAL_SPI_DISABLE_RX_IT(__HANDLE__)    IE2 &= ~(__HANDLE__->Instance == SPI1 ? UCA0RXIE : UCB0RXIE)
+#define __HAL_SPI_GET_TX_IT(__HANDLE__)        (IE2 & (__HANDLE__->Instance == SPI1 ? UCA0TXIE : UCB0TXIE))
 #define __HAL_SPI_GET_TX_FLAG(__HANDLE__)       !(IFG2 & (__HANDLE__->Instance == SPI1 ? UCA0TXIFG : UCB0TXIFG))
 #define __HAL_SPI_GET_RX_FLAG(__HANDLE__)       !(IFG2 & (__HANDLE__->Instance == SPI1 ? UCA0RXIFG : UCB0RXIFG))
 #define __HAL_SPI_CLEAR_TX_FLAG(__HANDLE__)     IFG2 &= ~(__HANDLE__->Instance == SPI1 ? UCA0TXIFG : UCB0TXIFG)
-#define __HAL_SPI_CLEAR_RX_FLAG(__HANDLE__)     IFG2 &= ~(__HANDLE__->Instance == SPI1 ? UCA0TXIFG : UCB0TXIFG)
+#define __HAL_SPI_CLEAR_RX_FLAG(__HANDLE__)     IFG2 &= ~(__HANDLE__->Instance == SPI1 ? UCA0RXIFG : UCB0RXIFG)
 
  #define HAL_SPI_TXBusy(SPIx)   !(IFG2 & (SPIx == SPI1 ? UCA0TXIFG : UCB0TXIFG)
 #define HAL_SPI_RXBusy(SPIx)   !(IFG2 & (SPIx == SPI1 ? UCA0TXIFG : UCB0TXIFG)
@@ -181,11 +205,15 @@ void HAL_SPI_Init(SPI_HandleTypeDef *hspi, SPI_InitTypeDef *SPI_InitStruct);
 void HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Size);
 void HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
 void HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint8_t *pRxData, uint16_t Size);
+uint16_t HAL_SPI_TransmitReceive_Block(SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint8_t *pRxData, uint16_t Size);
 uint16_t HAL_SPI_RegisterCallback(SPI_HandleTypeDef *hspi, HAL_SPI_CallbackIDTypeDef CallbackID, SPI_CallbackTypeDef Callback);
 void HAL_SPI_UnregisterCallback(SPI_HandleTypeDef *hspi, HAL_SPI_CallbackIDTypeDef CallbackID);
 uint16_t HAL_SPI_Transmit_IT(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
 uint16_t HAL_SPI_Receive_IT(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
 uint16_t HAL_SPI_TransmitReceive_IT(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData, uint16_t Size);
+#if HAL_SPI_USE_BLOCKING == (1)
+uint16_t HAL_SPI_TransmitReceive_Blocking(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, TickType_t Timeout);
+#endif
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,130 @@
+/**
+  ******************************************************************************
+  * @file       msp430_hal_spibus.h
+  * @author     Fernando Hermosillo Reynoso
+  * @brief      Header file of the shared SPI bus (transaction queue) HAL module.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 Universidad Panamericana.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DRIVERS_MSP430_HAL_SPIBUS_H_
+#define DRIVERS_MSP430_HAL_SPIBUS_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <Drivers/msp430x2xx.h>
+#include <Drivers/msp430_hal_gpio.h>
+#include <Drivers/msp430_hal_spi.h>
+
+#ifndef configHAL_SPIBUS_ISR_BURST
+#define configHAL_SPIBUS_ISR_BURST      (8)     // Bytes per interrupt for the fast devices
+#endif
+#ifndef configHAL_SPIBUS_FAST_PRESCALER
+#define configHAL_SPIBUS_FAST_PRESCALER (4)     // UCBRx up to which a byte is shorter than an interrupt
+#endif
+
+/** @addtogroup MSP430X2XX_HAL_Driver
+ * @{
+ */
+
+/** @addtogroup SPIBUS
+ * @{
+ */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief A slave on the bus. The bus reconfigures the USCI only when a
+ *        transaction is for another device than the one before.
+ */
+typedef struct
+{
+    GPIO_TypeDef_t *CS_Port;            /**< Chip select, a GPIO output idle at the inactive level */
+    uint8_t CS_Pin;
+    uint8_t CS_Active;                  /**< SPI_CS_LOW or SPI_CS_HIGH */
+    uint8_t Mode;                       /**< SPI_MODE_x */
+    uint8_t FirstBit;                   /**< SPI_MSB_FIRSTBIT or SPI_LSB_FIRSTBIT */
+    uint16_t Prescaler;                 /**< UCBRx */
+} SPIBUS_DeviceTypeDef;
+
+struct __SPIBUS_TransactionTypeDef;
+typedef void(* SPIBUSCallback_t)(struct __SPIBUS_TransactionTypeDef *);
+
+/**
+ * @brief One CS-framed transfer, owned by the caller until Status leaves
+ *        SPIBUS_PENDING.
+ */
+typedef struct __SPIBUS_TransactionTypeDef
+{
+    const SPIBUS_DeviceTypeDef *Device;
+    const uint8_t *pTxData;             /**< NULL sends SPI_DUMMY_BYTE */
+    uint8_t *pRxData;                   /**< NULL drops the received bytes */
+    uint16_t Size;
+    uint8_t Flags;                      /**< SPIBUS_FLAG_xxx */
+    volatile uint8_t Status;            /**< SPIBUS_IDLE, SPIBUS_PENDING or SPIBUS_DONE */
+    SPIBUSCallback_t Callback;          /**< Called on completion (__HAL_USCI_CALLBACK), may be NULL */
+    void *Arg;                          /**< For the callback */
+    struct __SPIBUS_TransactionTypeDef *Next;   /**< Transaction to run right after this one, NULL ends the chain */
+    struct __SPIBUS_TransactionTypeDef *Link;   /**< Queue link, private to the bus */
+} SPIBUS_TransactionTypeDef;
+
+typedef struct
+{
+    SPI_HandleTypeDef *hspi;            /**< Initialized master, the bus takes its RX interrupt */
+
+    SPIBUS_TransactionTypeDef *volatile Head;   /**< Transaction on the bus, NULL when idle */
+    SPIBUS_TransactionTypeDef *Tail;
+    const SPIBUS_DeviceTypeDef *Device; /**< Device the USCI is set up for */
+
+    // Transaction on the bus (RX interrupt)
+    const uint8_t *TxPtr;
+    uint8_t *RxPtr;
+    uint16_t Left;                      /**< Bytes still to receive */
+    uint8_t TxStep;                     /**< 0 when sending the dummy byte */
+    uint8_t Burst;                      /**< Bytes handled per interrupt */
+    uint8_t Dummy;
+
+    uint8_t RxIfg;                      /**< UCxRXIFG/UCxRXIE of the instance */
+} SPIBUS_HandleTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+// Transaction status
+#define SPIBUS_IDLE         (0x00)
+#define SPIBUS_PENDING      (0x01)      // Queued or on the bus
+#define SPIBUS_DONE         (0x02)
+
+// Transaction flags
+#define SPIBUS_FLAG_KEEP_CS (0x01)      // CS stays active for the next transaction (same device), e.g. command + data
+
+/* Exported macro ------------------------------------------------------------*/
+#define __HAL_SPIBUS_IS_DONE(__XFER__)  ( (__XFER__)->Status == SPIBUS_DONE )
+
+/* Exported functions --------------------------------------------------------*/
+uint16_t HAL_SPIBUS_Init(SPIBUS_HandleTypeDef *hbus, SPI_HandleTypeDef *hspi);
+uint16_t HAL_SPIBUS_DeviceInit(const SPIBUS_DeviceTypeDef *Device);
+uint16_t HAL_SPIBUS_Submit(SPIBUS_HandleTypeDef *hbus, SPIBUS_TransactionTypeDef *xfer);
+uint8_t HAL_SPIBUS_IsIdle(SPIBUS_HandleTypeDef *hbus);
+
+/* Private types -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private constants ---------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVERS_MSP430_HAL_SPIBUS_H_ */
@@ -50,10 +50,13 @@ typedef uint16_t HAL_BaseTypeDef;
 #define assert_param(param)                 if(!(param)) return;
 #define assert_param_ret(param,xReturn)     if(!(param)) return (xReturn);
 
+// __HAL_TRACE_MASK_BEGIN/__HAL_TRACE_MASK_END are defined in msp430x2xx.h
 #define __HAL_LOCK(__HANDLE__)      uint16_t __InterruptStatus = __get_SR_register() & 0x0008; \
                                     __disable_interrupt();                  \
+                                    if(__InterruptStatus) { __HAL_TRACE_MASK_BEGIN(); } \
                                     if((__HANDLE__)->Lock == HAL_LOCKED)    \
                                     {                                       \
+                                        if(__InterruptStatus) { __HAL_TRACE_MASK_END(); } \
                                         __bis_SR_register(__InterruptStatus);\
                                        return HAL_BUSY;                     \
                                     }                                       \
@@ -63,6 +66,7 @@ typedef uint16_t HAL_BaseTypeDef;
                                     }
 
 #define __HAL_UNLOCK(__HANDLE__)    (__HANDLE__)->Lock = HAL_UNLOCKED;    \
+                                    if(__InterruptStatus) { __HAL_TRACE_MASK_END(); } \
                                     __bis_SR_register(__InterruptStatus)
 
 #define UNUSED(VAR) (void)(VAR)
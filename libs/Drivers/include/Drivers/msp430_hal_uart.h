@@ -27,6 +27,20 @@
 /* Includes ------------------------------------------------------------------*/
 #include <Drivers/msp430x2xx.h>
 #include <Drivers/msp430_hal_usci.h>
+#include <Drivers/msp430_hal_uart_baud.h>
+#if configHAL_USE_UPRTOS == (1)
+#include <UpRTOS/UpTask.h>
+#endif
+
+// Blocking buffered calls, the task sleeps on a notification
+#if configHAL_USE_UPRTOS == (1) && configUSE_NOTIFICATIONS == (1)
+#define HAL_UART_USE_BLOCKING   (1)
+#else
+#define HAL_UART_USE_BLOCKING   (0)
+#endif
+#ifndef configHAL_UART_NOTIFY_INDEX
+#define configHAL_UART_NOTIFY_INDEX     (0)     // Notification index used by the blocking calls
+#endif
 
 /** @addtogroup MSP430X2XX_HAL_Driver
  * @{
@@ -57,8 +71,8 @@ typedef struct
 #if configHAL_CPU_HAVE_FPU == (1)
     uint32_t BaudRate;
 #else
-    uint16_t Prescaler;
-    uint8_t Modulation;
+    uint16_t Prescaler;     /**< UCBRx, see HAL_UART_BAUD_DEFINE */
+    uint8_t Modulation;     /**< UCAxMCTL, see HAL_UART_BAUD_DEFINE */
 #endif
     uint16_t WordLength;
     uint16_t StopBits;
@@ -68,6 +82,7 @@ typedef struct
 } UART_InitTypeDef;
 
 typedef void(* UARTCallback_t)(void *);
+typedef void(* UARTRxHook_t)(void *, uint8_t);
 
 typedef struct
 {
@@ -84,6 +99,37 @@ typedef struct
     HAL_BaseTypeDef Lock;
 } UART_HandleTypeDef;
 
+/**
+ * @brief Buffered UART. The TX/RX interrupts move the data between the rings
+ *        and the UART, the task side never waits on IFG2. Indexes run free
+ *        and are masked on access, each one is written by a single side, so
+ *        one writer task and one reader task need no lock.
+ */
+typedef struct
+{
+    UART_TypeDef *UARTx;
+
+    uint8_t *TxRing;                /**< TX storage, power of two size */
+    uint8_t *RxRing;                /**< RX storage, power of two size */
+    uint16_t TxMask;                /**< TX ring size - 1 */
+    uint16_t RxMask;                /**< RX ring size - 1 */
+    volatile uint16_t TxHead;       /**< Written by HAL_UART_WriteBuf */
+    volatile uint16_t TxTail;       /**< Written by the TX interrupt */
+    volatile uint16_t RxHead;       /**< Written by the RX interrupt */
+    volatile uint16_t RxTail;       /**< Written by HAL_UART_ReadBuf */
+    volatile uint16_t RxOverrun;    /**< Bytes dropped because the RX ring was full */
+
+    UARTRxHook_t RxHook;            /**< Takes each received byte instead of the RX ring (runs in the ISR) */
+    void *RxHookArg;
+
+#if HAL_UART_USE_BLOCKING == (1)
+    volatile TaskHandle_t TxWaiter; /**< Task waiting for TxWanted free bytes */
+    volatile TaskHandle_t RxWaiter; /**< Task waiting for RxWanted bytes */
+    volatile uint16_t TxWanted;
+    volatile uint16_t RxWanted;
+#endif
+} UART_BufHandleTypeDef;
+
 /* Exported constants --------------------------------------------------------*/
 #define UART_WORDLENGTH_7B  (BIT0)
 #define UART_WORDLENGTH_8B  (0)
@@ -110,6 +156,11 @@ typedef struct
 #define HAL_UART_RXBusy()   !(IFG2 & UCA0RXIFG)
 #define HAL_UART_ClearPendingFlag(FLAG) IFG2 &= ~(FLAG)
 
+#define IS_UART_RING_SIZE(SIZE)     ( ((SIZE) >= 2) && ((SIZE) <= 0x8000) && (((SIZE) & ((SIZE) - 1)) == 0) )
+
+#define HAL_UART_TxBufFree(__HBUF__)    ( (uint16_t)((__HBUF__)->TxMask + 1 - (uint16_t)((__HBUF__)->TxHead - (__HBUF__)->TxTail)) )
+#define HAL_UART_RxBufCount(__HBUF__)   ( (uint16_t)((__HBUF__)->RxHead - (__HBUF__)->RxTail) )
+
 /* Exported functions --------------------------------------------------------*/
 void HAL_UART_Init(UART_TypeDef *UARTx, UART_InitTypeDef *UART_InitStruct);
 void HAL_UART_Write(UART_TypeDef *UARTx, const unsigned char ByteToWrite);
@@ -120,6 +171,17 @@ void HAL_UART_Gets(UART_TypeDef *UARTx, unsigned char *StreamOut, unsigned char
 uint16_t HAL_UART_Write_IT(UART_HandleTypeDef *huart, UARTCallback_t TxCpltCallback, uint8_t *pData, uint8_t len);
 uint16_t HAL_UART_Read_IT(UART_HandleTypeDef *huart, UARTCallback_t RxCpltCallback, uint8_t *pData, uint8_t len);
 
+uint16_t HAL_UART_InitBuf(UART_BufHandleTypeDef *hbuf, UART_TypeDef *UARTx,
+                          uint8_t *pTxRing, uint16_t TxRingSize,
+                          uint8_t *pRxRing, uint16_t RxRingSize);
+uint16_t HAL_UART_WriteBuf(UART_BufHandleTypeDef *hbuf, const uint8_t *pData, uint16_t len, uint16_t *pWritten);
+uint16_t HAL_UART_ReadBuf(UART_BufHandleTypeDef *hbuf, uint8_t *pData, uint16_t len, uint16_t *pRead);
+uint16_t HAL_UART_SetRxHook(UART_BufHandleTypeDef *hbuf, UARTRxHook_t RxHook, void *arg);
+#if HAL_UART_USE_BLOCKING == (1)
+uint16_t HAL_UART_WriteBuf_Blocking(UART_BufHandleTypeDef *hbuf, const uint8_t *pData, uint16_t len, uint16_t *pWritten, TickType_t Timeout);
+uint16_t HAL_UART_ReadBuf_Blocking(UART_BufHandleTypeDef *hbuf, uint8_t *pData, uint16_t len, uint16_t *pRead, TickType_t Timeout);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,174 @@
+/**
+  ******************************************************************************
+  * @file       msp430_hal_uart_baud.h
+  * @author     Fernando Hermosillo Reynoso
+  * @brief      Compile-time UART baud rate divisor and modulation (USCI_A,
+  *             low-frequency mode).
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 Universidad Panamericana.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DRIVERS_MSP430_HAL_UART_BAUD_H_
+#define DRIVERS_MSP430_HAL_UART_BAUD_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/** @addtogroup MSP430X2XX_HAL_Driver
+ * @{
+ */
+
+/** @addtogroup UART
+ * @{
+ */
+
+/* Exported constants --------------------------------------------------------*/
+#define UART_BAUD_FRAME_BITS    (11)    // Start, 8 data, parity, stop
+#define UART_MCTL_BRS_S         (1)     // UCBRSx is UCAxMCTL<3:1>
+
+/* Exported macro ------------------------------------------------------------*/
+/**
+ * @brief Declare the UCAxBR0, UCAxBR1 and UCAxMCTL values of a BRCLK/BAUD
+ *        pair as NAME_BR0, NAME_BR1 and NAME_MCTL, all worked out by the
+ *        compiler (no float code in the image).
+ *
+ *        UCBRx = INT(BRCLK/BAUD), UCOS16 = 0. UCBRSx is the modulation
+ *        pattern with the lowest worst-case transmit bit error over an
+ *        UART_BAUD_FRAME_BITS frame, the best one is always next to
+ *        8*frac(BRCLK/BAUD), so the two around it are compared.
+ *
+ *            HAL_UART_BAUD_DEFINE(UART_115200, 16000000UL, 115200UL);
+ *
+ *            UART_InitStruct.Prescaler = HAL_UART_BAUD_PRESCALER(UART_115200);
+ *            UART_InitStruct.Modulation = UART_115200_MCTL;
+ *
+ *        In C the errors are compared in 1/2048 bit steps, so a near tie may
+ *        go to the other pattern (at most 0.2% of a bit worse). In C++ the
+ *        search is exact over all eight patterns (HAL_UART_BaudCalc).
+ */
+#ifndef __cplusplus
+#define HAL_UART_BAUD_DEFINE(NAME, BRCLK, BAUD)                                                     \
+    enum                                                                                            \
+    {                                                                                               \
+        NAME##_BR0 = (int)(((BRCLK)/(BAUD)) & 0xFF),                                                \
+        NAME##_BR1 = (int)(((BRCLK)/(BAUD)) >> 8),                                                  \
+        NAME##_F = (int)((((unsigned long long)(BRCLK) % (BAUD))*(2*__UART_BAUD_ONE)/(BAUD) + 1)/2),\
+        NAME##_LO = (NAME##_F*8/__UART_BAUD_ONE < 7) ? NAME##_F*8/__UART_BAUD_ONE : 7,              \
+        NAME##_HI = (NAME##_LO < 7) ? NAME##_LO + 1 : 7,                                            \
+        __UART_BAUD_ERRORS(NAME, LO),                                                               \
+        __UART_BAUD_ERRORS(NAME, HI),                                                               \
+        NAME##_MCTL = ((__UART_BAUD_WORST(NAME, HI) < __UART_BAUD_WORST(NAME, LO)) ?                \
+                        NAME##_HI : NAME##_LO) << UART_MCTL_BRS_S                                   \
+    }
+#else
+#define HAL_UART_BAUD_DEFINE(NAME, BRCLK, BAUD)                                                     \
+    constexpr UART_BaudTypeDef NAME##_BAUD = HAL_UART_BaudCalc((BRCLK), (BAUD));                    \
+    enum                                                                                            \
+    {                                                                                               \
+        NAME##_BR0 = NAME##_BAUD.Prescaler & 0xFF,                                                  \
+        NAME##_BR1 = NAME##_BAUD.Prescaler >> 8,                                                    \
+        NAME##_MCTL = NAME##_BAUD.Modulation                                                        \
+    }
+#endif
+
+#define HAL_UART_BAUD_PRESCALER(NAME)   ( (uint16_t)(((uint16_t)NAME##_BR1 << 8) | NAME##_BR0) )
+
+/* Private constants ---------------------------------------------------------*/
+#define __UART_BAUD_ONE     (2048)  // One bit time in the C error comparison
+
+/* Private macros ------------------------------------------------------------*/
+// Modulated bits up to bit J (0..7) of pattern S, 3 bits per bit index (SLAU144 table 15-2)
+#define __UART_BAUD_CUM(S, J)                                                                       \
+    ( (int)(( ((S) == 0) ? 0x000000UL : ((S) == 1) ? 0x249248UL : ((S) == 2) ? 0x491248UL :         \
+              ((S) == 3) ? 0x6DA448UL : ((S) == 4) ? 0x8DA448UL : ((S) == 5) ? 0xB23688UL :         \
+              ((S) == 6) ? 0xD63688UL : 0xFAC688UL ) >> (3*(J))) & 0x07 )
+
+// Transmit error at the end of bit J (1/__UART_BAUD_ONE bit), the pattern repeats after 8 bits
+#define __UART_BAUD_ERR(F, S, J)                                                                    \
+    __UART_BAUD_ABS( ((J) < 8 ? __UART_BAUD_CUM(S, (J) & 7) : (S) + __UART_BAUD_CUM(S, (J) & 7))    \
+                     *__UART_BAUD_ONE - ((J) + 1)*(F) )
+
+#define __UART_BAUD_ERRORS(NAME, S)                                                                 \
+    NAME##_##S##0 = __UART_BAUD_ERR(NAME##_F, NAME##_##S, 0),                                       \
+    NAME##_##S##1 = __UART_BAUD_ERR(NAME##_F, NAME##_##S, 1),                                       \
+    NAME##_##S##2 = __UART_BAUD_ERR(NAME##_F, NAME##_##S, 2),                                       \
+    NAME##_##S##3 = __UART_BAUD_ERR(NAME##_F, NAME##_##S, 3),                                       \
+    NAME##_##S##4 = __UART_BAUD_ERR(NAME##_F, NAME##_##S, 4),                                       \
+    NAME##_##S##5 = __UART_BAUD_ERR(NAME##_F, NAME##_##S, 5),                                       \
+    NAME##_##S##6 = __UART_BAUD_ERR(NAME##_F, NAME##_##S, 6),                                       \
+    NAME##_##S##7 = __UART_BAUD_ERR(NAME##_F, NAME##_##S, 7),                                       \
+    NAME##_##S##8 = __UART_BAUD_ERR(NAME##_F, NAME##_##S, 8),                                       \
+    NAME##_##S##9 = __UART_BAUD_ERR(NAME##_F, NAME##_##S, 9),                                       \
+    NAME##_##S##10 = __UART_BAUD_ERR(NAME##_F, NAME##_##S, 10)
+
+#define __UART_BAUD_WORST(NAME, S)                                                                  \
+    __UART_BAUD_MAX(__UART_BAUD_MAX(__UART_BAUD_MAX(NAME##_##S##0, NAME##_##S##1),                  \
+                                    __UART_BAUD_MAX(NAME##_##S##2, NAME##_##S##3)),                 \
+                    __UART_BAUD_MAX(__UART_BAUD_MAX(__UART_BAUD_MAX(NAME##_##S##4, NAME##_##S##5),  \
+                                                    __UART_BAUD_MAX(NAME##_##S##6, NAME##_##S##7)), \
+                                    __UART_BAUD_MAX(__UART_BAUD_MAX(NAME##_##S##8, NAME##_##S##9),  \
+                                                    NAME##_##S##10)))
+
+#define __UART_BAUD_ABS(X)      ( ((X) < 0) ? -(X) : (X) )
+#define __UART_BAUD_MAX(A, B)   ( ((A) > (B)) ? (A) : (B) )
+
+/* C++ -----------------------------------------------------------------------*/
+#ifdef __cplusplus
+typedef struct
+{
+    uint16_t Prescaler;     /**< UCBRx */
+    uint8_t Modulation;     /**< UCAxMCTL (UCBRSx << 1, UCOS16 = 0) */
+} UART_BaudTypeDef;
+
+/**
+ * @brief Worst-case transmit error of modulation pattern BRS, in BRCLK*BAUD
+ *        units: |((j+1)*UCBRx + modulated bits up to j)*BAUD - (j+1)*BRCLK|
+ */
+constexpr uint64_t HAL_UART_BaudError(uint32_t brclk, uint32_t baud, uint8_t brs)
+{
+    const uint8_t pattern[8] = { 0x00, 0x02, 0x22, 0x2A, 0xAA, 0xAE, 0xEE, 0xFE };  // Bit n: bit n is one BRCLK longer
+    const uint64_t br = brclk / baud;
+    uint64_t worst = 0;
+    uint64_t modulated = 0;
+
+    for(uint8_t j = 0; j < UART_BAUD_FRAME_BITS; j++)
+    {
+        modulated += (pattern[brs] >> (j & 7)) & 0x01;
+
+        const uint64_t actual = ((j + 1)*br + modulated)*baud;
+        const uint64_t ideal = (uint64_t)(j + 1)*brclk;
+        const uint64_t error = (actual > ideal) ? actual - ideal : ideal - actual;
+        if(error > worst) worst = error;
+    }
+
+    return worst;
+}
+
+/**
+ * @brief UCBRx and the UCBRSx with the lowest worst-case error (the lowest
+ *        UCBRSx on a tie)
+ */
+constexpr UART_BaudTypeDef HAL_UART_BaudCalc(uint32_t brclk, uint32_t baud)
+{
+    uint8_t best = 0;
+
+    for(uint8_t brs = 1; brs < 8; brs++)
+    {
+        if(HAL_UART_BaudError(brclk, baud, brs) < HAL_UART_BaudError(brclk, baud, best)) best = brs;
+    }
+
+    return UART_BaudTypeDef{ (uint16_t)(brclk / baud), (uint8_t)(best << UART_MCTL_BRS_S) };
+}
+#endif
+
+#endif /* DRIVERS_MSP430_HAL_UART_BAUD_H_ */
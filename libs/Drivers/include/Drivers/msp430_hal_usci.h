@@ -27,6 +27,9 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include <Drivers/msp430x2xx.h>
+#if configHAL_USE_UPRTOS == (1)
+#include <UpRTOS/UpDefer.h>
+#endif
 
 /* Exported types ------------------------------------------------------------*/
 typedef void(* USCICallback_t)(void *);
@@ -70,6 +73,24 @@ typedef struct
 #define USCI_ERROR_DIFF         (6)
 
 /* Exported macro ------------------------------------------------------------*/
+// Completion callbacks run in the UpRTOS deferred call daemon instead of the
+// ISR, or in the ISR when the deferred call queue is full
+#if configHAL_USE_UPRTOS == (1) && configUSE_DEFERRED_CALLS == (1)
+#define __HAL_USCI_CALLBACK(__CALLBACK__,__ARG__)   do {\
+                                                        UBaseType_t xDeferWoken__ = pdFALSE;\
+                                                        if( xDeferFunctionCallFromISR((DeferredFunction_t)(__CALLBACK__), (void *)(__ARG__), &xDeferWoken__) ) { portYIELD_FROM_ISR(xDeferWoken__); }\
+                                                        else { (__CALLBACK__)(__ARG__); }\
+                                                    } while(0)
+#else
+#define __HAL_USCI_CALLBACK(__CALLBACK__,__ARG__)   (__CALLBACK__)(__ARG__)
+#endif
+
+// Interrupt bodies run on the UpRTOS interrupt stack instead of the task stack
+#if configHAL_USE_UPRTOS == (1) && configUSE_ISR_STACK == (1)
+#define __HAL_USCI_RUN_ISR(__HANDLER__)     vPortRunOnISRStack((TaskFunction_t)(__HANDLER__), NULL)
+#else
+#define __HAL_USCI_RUN_ISR(__HANDLER__)     (__HANDLER__)(NULL)
+#endif
 
 /* Exported variables --------------------------------------------------------*/
 
@@ -31,7 +31,22 @@
 /* Exported types ------------------------------------------------------------*/
 
 /* Exported constants --------------------------------------------------------*/
-#define configHAL_CPU_HAVE_FPU  (1)
+#ifndef configHAL_CPU_HAVE_FPU
+#define configHAL_CPU_HAVE_FPU  (0)     // 1: baud rates worked out at run time with float
+#endif
+#ifndef configHAL_USE_UPRTOS
+#define configHAL_USE_UPRTOS    (0)
+#endif
+
+// Interrupt-masked time tracing of the HAL locks (__HAL_LOCK/__HAL_UNLOCK)
+#if configHAL_USE_UPRTOS == (1)
+#include <UpRTOS/UpTrace.h>
+#define __HAL_TRACE_MASK_BEGIN()    traceMASK_BEGIN()
+#define __HAL_TRACE_MASK_END()      traceMASK_END()
+#else
+#define __HAL_TRACE_MASK_BEGIN()
+#define __HAL_TRACE_MASK_END()
+#endif
 
 // GPIO ===========================================
 #define configHAL_GPIO_NUM  (2)
@@ -47,5 +47,14 @@
 #define USCI_CTL1_OS16_M    BIT0
 #define USCI_CTL1_OS16_S    (0)
 
+#define USCI_STAT_LISTEN_M  BIT7
+#define USCI_STAT_FE_M      BIT6
+#define USCI_STAT_OE_M      BIT5
+#define USCI_STAT_PE_M      BIT4
+#define USCI_STAT_BRK_M     BIT3
+#define USCI_STAT_RXERR_M   BIT2
+#define USCI_STAT_IDLE_M    BIT1
+#define USCI_STAT_BUSY_M    BIT0
+
 
 #endif /* DRIVERS_USCI_REG_H_ */
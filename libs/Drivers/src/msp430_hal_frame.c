@@ -0,0 +1,462 @@
+/**
+  ******************************************************************************
+  * @file       msp430_hal_frame.c
+  * @author     Fernando Hermosillo Reynoso
+  * @brief      Source file of the UART packet framing (COBS/SLIP) HAL module.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 Universidad Panamericana.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <Drivers/msp430_hal_frame.h>
+#include <stddef.h>
+
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+    UART_BufHandleTypeDef *hbuf;
+    uint8_t Buffer[8];
+    uint8_t Count;
+} FRAME_WriterTypeDef;
+
+
+/* Private constants ---------------------------------------------------------*/
+#define FRAME_RX_IDLE       (0x00)  // Between frames
+#define FRAME_RX_DATA       (0x01)  // Decoding into RxPacket
+#define FRAME_RX_DISCARD    (0x02)  // Skipping to the next delimiter
+
+#define FRAME_READY_MASK    (0x07)  // Ready ring has 8 slots, it never fills
+
+#define COBS_DELIMITER      (0x00)
+#define COBS_MAX_CODE       (0xFF)
+
+#define SLIP_END            (0xC0)
+#define SLIP_ESC            (0xDB)
+#define SLIP_ESC_END        (0xDC)
+#define SLIP_ESC_ESC        (0xDD)
+
+#if configHAL_FRAME_POOL_SIZE < 2 || configHAL_FRAME_POOL_SIZE > 8
+#error "configHAL_FRAME_POOL_SIZE must be between 2 and 8"
+#endif
+#if configHAL_FRAME_MAX_LENGTH <= FRAME_CRC_SIZE || configHAL_FRAME_MAX_LENGTH > 254
+#error "configHAL_FRAME_MAX_LENGTH must fit the CRC and a single COBS block"
+#endif
+
+
+/* Private macros ------------------------------------------------------------*/
+// Worst case bytes on the wire for a payload of LEN bytes
+#define FRAME_COBS_WORST(LEN)   ( (LEN) + FRAME_CRC_SIZE + 2 )
+#define FRAME_SLIP_WORST(LEN)   ( 2*((LEN) + FRAME_CRC_SIZE) + 2 )
+
+
+/* Private variables ---------------------------------------------------------*/
+// CRC-16/CCITT-FALSE (0x1021), one nibble per lookup keeps the table in 32 bytes
+static const uint16_t crc16_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+
+/* Private functions ---------------------------------------------------------*/
+static void HAL_FRAME_RxHook(void *arg, uint8_t data);
+static void HAL_FRAME_RxOpen(FRAME_HandleTypeDef *hframe);
+static void HAL_FRAME_RxByte(FRAME_HandleTypeDef *hframe, uint8_t data);
+static void HAL_FRAME_RxEnd(FRAME_HandleTypeDef *hframe);
+static void HAL_FRAME_Put(FRAME_WriterTypeDef *writer, uint8_t data);
+static void HAL_FRAME_Flush(FRAME_WriterTypeDef *writer);
+static inline uint16_t HAL_FRAME_Crc16Byte(uint16_t crc, uint8_t data);
+
+
+/* Reference functions -------------------------------------------------------*/
+/**
+ * @brief Attach the frame layer to a buffered UART. From now on the RX
+ *        interrupt decodes the incoming bytes, HAL_UART_ReadBuf sees none.
+ */
+uint16_t HAL_FRAME_Init(FRAME_HandleTypeDef *hframe, UART_BufHandleTypeDef *hbuf, uint8_t Mode)
+{
+    assert_param_ret(hframe != NULL && hbuf != NULL, HAL_ERROR);
+    assert_param_ret(IS_FRAME_MODE(Mode), HAL_ERROR);
+
+    hframe->hbuf = hbuf;
+    hframe->Mode = Mode;
+    hframe->FreeMask = (uint8_t)((1U << configHAL_FRAME_POOL_SIZE) - 1);
+    hframe->ReadyHead = 0;
+    hframe->ReadyTail = 0;
+
+    hframe->RxPacket = NULL;
+    hframe->RxLength = 0;
+    hframe->RxCrc = FRAME_CRC16_INIT;
+    hframe->RxCode = 0;
+    hframe->RxLeft = 0;
+    hframe->RxState = FRAME_RX_IDLE;
+
+    hframe->CrcErrors = 0;
+    hframe->Overflows = 0;
+    hframe->Dropped = 0;
+#if HAL_UART_USE_BLOCKING == (1)
+    hframe->RxWaiter = NULL;
+#endif
+
+    return HAL_UART_SetRxHook(hbuf, HAL_FRAME_RxHook, hframe);
+}
+
+/**
+ * @brief Encode a packet (payload + CRC) into the TX ring. The frame is
+ *        never written partially: HAL_BUSY if the ring lacks room for the
+ *        worst case encoding.
+ */
+uint16_t HAL_FRAME_Send(FRAME_HandleTypeDef *hframe, const uint8_t *pData, uint16_t len)
+{
+    FRAME_WriterTypeDef writer;
+    uint8_t crc_bytes[FRAME_CRC_SIZE];
+    uint16_t crc;
+    uint16_t total;
+    uint16_t worst;
+
+    assert_param_ret(hframe != NULL && (pData != NULL || !len), HAL_ERROR);
+    assert_param_ret(len <= configHAL_FRAME_MAX_LENGTH - FRAME_CRC_SIZE, HAL_ERROR);
+
+    worst = (hframe->Mode == FRAME_MODE_COBS) ? FRAME_COBS_WORST(len) : FRAME_SLIP_WORST(len);
+    if(HAL_UART_TxBufFree(hframe->hbuf) < worst) return HAL_BUSY;
+
+    crc = HAL_FRAME_Crc16(FRAME_CRC16_INIT, pData, len);
+    crc_bytes[0] = (uint8_t)(crc >> 8);
+    crc_bytes[1] = (uint8_t)(crc & 0xFF);
+    total = len + FRAME_CRC_SIZE;
+
+    writer.hbuf = hframe->hbuf;
+    writer.Count = 0;
+
+    #define FRAME_BYTE(i)   ( ((i) < len) ? pData[(i)] : crc_bytes[(i) - len] )
+    if(hframe->Mode == FRAME_MODE_COBS)
+    {
+        // The frame fits a single block run (<= 254 bytes), so every block
+        // ends on a zero or on the end of the frame
+        uint16_t start = 0;
+        uint16_t end;
+        while(1)
+        {
+            for(end = start; end < total && FRAME_BYTE(end) != 0x00; end++);
+            HAL_FRAME_Put(&writer, (uint8_t)(end - start + 1));
+            for(; start < end; start++) HAL_FRAME_Put(&writer, FRAME_BYTE(start));
+            if(end == total) break;
+            start = end + 1;    // Skip the zero, the receiver puts it back
+        }
+        HAL_FRAME_Put(&writer, COBS_DELIMITER);
+    }
+    else
+    {
+        uint8_t data;
+        HAL_FRAME_Put(&writer, SLIP_END);   // Flushes any line noise on the receiver
+        for(uint16_t i = 0; i < total; i++)
+        {
+            data = FRAME_BYTE(i);
+            if(data == SLIP_END)
+            {
+                HAL_FRAME_Put(&writer, SLIP_ESC);
+                HAL_FRAME_Put(&writer, SLIP_ESC_END);
+            }
+            else if(data == SLIP_ESC)
+            {
+                HAL_FRAME_Put(&writer, SLIP_ESC);
+                HAL_FRAME_Put(&writer, SLIP_ESC_ESC);
+            }
+            else
+            {
+                HAL_FRAME_Put(&writer, data);
+            }
+        }
+        HAL_FRAME_Put(&writer, SLIP_END);
+    }
+    #undef FRAME_BYTE
+
+    HAL_FRAME_Flush(&writer);
+
+    return HAL_OK;
+}
+
+/**
+ * @brief Take the oldest complete packet, HAL_BUSY if there is none. The
+ *        packet belongs to the caller until HAL_FRAME_Release.
+ */
+uint16_t HAL_FRAME_Receive(FRAME_HandleTypeDef *hframe, FRAME_PacketTypeDef **ppPacket)
+{
+    assert_param_ret(hframe != NULL && ppPacket != NULL, HAL_ERROR);
+
+    if(hframe->ReadyHead == hframe->ReadyTail)
+    {
+        *ppPacket = NULL;
+        return HAL_BUSY;
+    }
+
+    *ppPacket = &hframe->Pool[hframe->Ready[hframe->ReadyTail & FRAME_READY_MASK]];
+    hframe->ReadyTail++;
+
+    return HAL_OK;
+}
+
+/**
+ * @brief Give a received packet back to the pool.
+ */
+uint16_t HAL_FRAME_Release(FRAME_HandleTypeDef *hframe, FRAME_PacketTypeDef *pPacket)
+{
+    assert_param_ret(hframe != NULL, HAL_ERROR);
+    assert_param_ret(pPacket >= &hframe->Pool[0] && pPacket < &hframe->Pool[configHAL_FRAME_POOL_SIZE], HAL_ERROR);
+
+    uint8_t mask = 1U << (uint8_t)(pPacket - hframe->Pool);
+
+    // The RX interrupt takes packets from the same mask
+    uint16_t __InterruptStatus = __get_SR_register() & 0x0008;
+    __disable_interrupt();
+    hframe->FreeMask |= mask;
+    __bis_SR_register(__InterruptStatus);
+
+    return HAL_OK;
+}
+
+#if HAL_UART_USE_BLOCKING == (1)
+/**
+ * @brief Sleep until a complete packet arrives or the timeout expires
+ *        (HAL_BUSY). The notification is given by the RX interrupt.
+ */
+uint16_t HAL_FRAME_Receive_Blocking(FRAME_HandleTypeDef *hframe, FRAME_PacketTypeDef **ppPacket, TickType_t Timeout)
+{
+    TickType_t start = xTaskGetTickCount();
+    TickType_t elapsed;
+
+    assert_param_ret(hframe != NULL && ppPacket != NULL, HAL_ERROR);
+
+    while(HAL_FRAME_Receive(hframe, ppPacket) != HAL_OK)
+    {
+        elapsed = xTaskGetTickCount() - start;
+        if(Timeout != portMAX_DELAY && elapsed >= Timeout) return HAL_BUSY;
+
+        // Drop a notification given after an earlier re-check skipped the wait
+        (void)usTaskNotifyTakeIndexed(configHAL_UART_NOTIFY_INDEX, pdTRUE, 0);
+
+        hframe->RxWaiter = xTaskGetCurrentTaskHandle();
+        if(hframe->ReadyHead == hframe->ReadyTail)
+        {
+            (void)usTaskNotifyTakeIndexed(configHAL_UART_NOTIFY_INDEX, pdTRUE, (Timeout == portMAX_DELAY) ? portMAX_DELAY : Timeout - elapsed);
+        }
+        hframe->RxWaiter = NULL;
+    }
+
+    return HAL_OK;
+}
+#endif
+
+/**
+ * @brief CRC-16/CCITT-FALSE of a buffer, start from FRAME_CRC16_INIT.
+ *        A frame followed by its CRC (MSB first) gives 0.
+ */
+uint16_t HAL_FRAME_Crc16(uint16_t crc, const uint8_t *pData, uint16_t len)
+{
+    while(len--) crc = HAL_FRAME_Crc16Byte(crc, *pData++);
+
+    return crc;
+}
+
+
+/* Private reference functions -----------------------------------------------*/
+static inline uint16_t HAL_FRAME_Crc16Byte(uint16_t crc, uint8_t data)
+{
+    crc = (crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data >> 4)];
+    crc = (crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data & 0x0F)];
+
+    return crc;
+}
+
+static void HAL_FRAME_Put(FRAME_WriterTypeDef *writer, uint8_t data)
+{
+    writer->Buffer[writer->Count++] = data;
+    if(writer->Count == sizeof(writer->Buffer)) HAL_FRAME_Flush(writer);
+}
+
+static void HAL_FRAME_Flush(FRAME_WriterTypeDef *writer)
+{
+    // Room was checked up front, the ring takes everything
+    (void)HAL_UART_WriteBuf(writer->hbuf, writer->Buffer, writer->Count, NULL);
+    writer->Count = 0;
+}
+
+/**
+ * @brief Called by the UART RX interrupt for every byte.
+ */
+static void HAL_FRAME_RxHook(void *arg, uint8_t data)
+{
+    FRAME_HandleTypeDef *hframe = (FRAME_HandleTypeDef *)arg;
+
+    if(hframe->Mode == FRAME_MODE_COBS)
+    {
+        if(data == COBS_DELIMITER)
+        {
+            // A block cut short is a broken frame
+            if(hframe->RxState == FRAME_RX_DATA && hframe->RxLeft != 0)
+            {
+                hframe->CrcErrors++;
+                hframe->RxState = FRAME_RX_DISCARD;
+            }
+            HAL_FRAME_RxEnd(hframe);
+        }
+        else if(hframe->RxState == FRAME_RX_DISCARD)
+        {
+            return;
+        }
+        else if(hframe->RxLeft == 0)
+        {
+            // Code byte, the previous block (unless a full one) ended on a zero
+            if(hframe->RxState == FRAME_RX_IDLE)
+            {
+                HAL_FRAME_RxOpen(hframe);
+            }
+            else if(hframe->RxCode != COBS_MAX_CODE)
+            {
+                HAL_FRAME_RxByte(hframe, 0x00);
+            }
+            hframe->RxCode = data;
+            hframe->RxLeft = data - 1;
+        }
+        else
+        {
+            HAL_FRAME_RxByte(hframe, data);
+            hframe->RxLeft--;
+        }
+    }
+    else
+    {
+        if(data == SLIP_END)
+        {
+            if(hframe->RxState == FRAME_RX_DATA && hframe->RxLeft != 0)
+            {
+                hframe->CrcErrors++;
+                hframe->RxState = FRAME_RX_DISCARD;
+            }
+            HAL_FRAME_RxEnd(hframe);
+        }
+        else if(hframe->RxState == FRAME_RX_DISCARD)
+        {
+            return;
+        }
+        else if(data == SLIP_ESC)
+        {
+            hframe->RxLeft = 1;
+        }
+        else
+        {
+            if(hframe->RxLeft != 0)
+            {
+                hframe->RxLeft = 0;
+                if(data == SLIP_ESC_END) data = SLIP_END;
+                else if(data == SLIP_ESC_ESC) data = SLIP_ESC;
+                else
+                {
+                    hframe->CrcErrors++;
+                    hframe->RxState = FRAME_RX_DISCARD;
+                    return;
+                }
+            }
+            if(hframe->RxState == FRAME_RX_IDLE) HAL_FRAME_RxOpen(hframe);
+            HAL_FRAME_RxByte(hframe, data);
+        }
+    }
+}
+
+/**
+ * @brief First byte of a frame: take a packet from the pool, unless the
+ *        decoder still holds a rejected one.
+ */
+static void HAL_FRAME_RxOpen(FRAME_HandleTypeDef *hframe)
+{
+    if(hframe->RxPacket == NULL)
+    {
+        uint8_t free = hframe->FreeMask;
+        uint8_t index = 0;
+
+        if(!free)
+        {
+            hframe->Dropped++;
+            hframe->RxState = FRAME_RX_DISCARD;
+            return;
+        }
+        while(!(free & 0x01))
+        {
+            free >>= 1;
+            index++;
+        }
+        hframe->FreeMask &= ~(1U << index);
+        hframe->RxPacket = &hframe->Pool[index];
+    }
+
+    hframe->RxState = FRAME_RX_DATA;
+    hframe->RxLength = 0;
+    hframe->RxCrc = FRAME_CRC16_INIT;
+}
+
+/**
+ * @brief Store a decoded byte.
+ */
+static void HAL_FRAME_RxByte(FRAME_HandleTypeDef *hframe, uint8_t data)
+{
+    if(hframe->RxState != FRAME_RX_DATA) return;
+
+    if(hframe->RxLength >= configHAL_FRAME_MAX_LENGTH)
+    {
+        hframe->Overflows++;
+        hframe->RxState = FRAME_RX_DISCARD;
+        return;
+    }
+
+    hframe->RxPacket->Data[hframe->RxLength++] = data;
+    hframe->RxCrc = HAL_FRAME_Crc16Byte(hframe->RxCrc, data);
+}
+
+/**
+ * @brief Delimiter seen: publish the packet if its CRC holds. A rejected
+ *        packet stays attached to the decoder for the next frame.
+ */
+static void HAL_FRAME_RxEnd(FRAME_HandleTypeDef *hframe)
+{
+    if(hframe->RxState == FRAME_RX_DATA)
+    {
+        if(hframe->RxLength < FRAME_CRC_SIZE || hframe->RxCrc != 0)
+        {
+            hframe->CrcErrors++;
+        }
+        else
+        {
+            hframe->RxPacket->Length = hframe->RxLength - FRAME_CRC_SIZE;
+            hframe->Ready[hframe->ReadyHead & FRAME_READY_MASK] = (uint8_t)(hframe->RxPacket - hframe->Pool);
+            hframe->ReadyHead++;
+            hframe->RxPacket = NULL;
+
+#if HAL_UART_USE_BLOCKING == (1)
+            if(hframe->RxWaiter != NULL)
+            {
+                UBaseType_t xHigherPriorityTaskWoken = pdFALSE;
+                TaskHandle_t xWaiter = hframe->RxWaiter;
+
+                hframe->RxWaiter = NULL;
+                vTaskNotifyGiveIndexedFromISR(xWaiter, configHAL_UART_NOTIFY_INDEX, &xHigherPriorityTaskWoken);
+                portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+            }
+#endif
+        }
+    }
+
+    hframe->RxState = FRAME_RX_IDLE;
+    hframe->RxLength = 0;
+    hframe->RxCrc = FRAME_CRC16_INIT;
+    hframe->RxCode = 0;
+    hframe->RxLeft = 0;
+}
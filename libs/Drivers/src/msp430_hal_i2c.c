@@ -21,17 +21,13 @@
 #include <Drivers/msp430_hal_i2c.h>
 #include <Drivers/usci_reg.h>
 #include <Drivers/msp430_hal_bcm.h>
+#include <stddef.h>
 
 /* Private types -------------------------------------------------------------*/
 
 /* Private variables ---------------------------------------------------------*/
 
 /* Private constants ---------------------------------------------------------*/
-#define I2C_STATE_IDLE      (0)
-#define I2C_STATE_NACK      (1)
-#define I2C_STATE_TX        (2)
-#define I2C_STATE_RX        (3)
-#define I2C_STATE_TIMEOUT   (4)
 
 /* Private macros ------------------------------------------------------------*/
 #define HAL_I2C_IT_START(__HANDLE__)    __HANDLE__->Instance->CTL1 |= UCTXSTT
@@ -50,6 +46,16 @@
  */
 static uint16_t HAL_I2C_Ack(I2C_TypeDef *I2Cx);
 
+static uint16_t HAL_I2C_IT_Begin(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t RegCount, uint8_t Reg,
+                                 const uint8_t *TxBuffer, uint8_t TxCount, uint8_t *RxBuffer, uint8_t RxCount);
+static void HAL_I2C_IT_StartRx(I2C_HandleTypeDef *hi2c);
+static void HAL_I2C_IT_Idle(I2C_HandleTypeDef *hi2c, uint8_t ErrorCode);
+static void HAL_I2C_IT_End(I2C_HandleTypeDef *hi2c);
+static void HAL_I2C_IT_StopWait(I2C_HandleTypeDef *hi2c, uint8_t FromISR);
+#if configHAL_USE_UPRTOS == (1) && configUSE_DEFERRED_CALLS == (1)
+static void HAL_I2C_IT_StopDeferred(void *argin);
+#endif
+
 static void HAL_I2C_EV_ISR(void *argin);
 static void HAL_I2C_ER_ISR(void *argin);
 
@@ -263,7 +269,7 @@ uint16_t HAL_I2C_Transfer(I2C_TypeDef *I2Cx, I2C_MessageTypeDef *I2C_MessageStru
     assert_param_ret(!(I2Cx->STAT & UCBBUSY), I2C_ERROR_BUSY);
 
     // Start
-    int16_t err = HAL_I2C_Start(I2Cx, I2C_MessageStruct->DevAddress);
+    int16_t err = HAL_I2C_Begin(I2Cx, I2C_MessageStruct->DevAddress);
     if(err != I2C_ERROR_NONE) return err;
 
     // Write
@@ -276,13 +282,13 @@ uint16_t HAL_I2C_Transfer(I2C_TypeDef *I2Cx, I2C_MessageTypeDef *I2C_MessageStru
     // Read
     if(I2C_MessageStruct->RxCount)
     {
-        HAL_I2C_Stop(I2Cx, I2C_RESTART_RX);
+        // HAL_I2C_Read sends the repeated start
         err = HAL_I2C_Read(I2Cx, (uint8_t *)I2C_MessageStruct->RxBuffer, I2C_MessageStruct->RxCount);
         if(err != I2C_ERROR_NONE) return err;
     }
     else
     {
-        HAL_I2C_Stop(I2Cx, I2C_STOP);
+        HAL_I2C_End(I2Cx, I2C_STOP);
     }
 
     return I2C_ERROR_NONE;
@@ -406,10 +412,10 @@ uint16_t HAL_I2C_Alloc_ISR(I2C_HandleTypeDef *hi2c)
     };
     uint16_t err = HAL_USCI_Intr_Alloc(&cfg) == USCI_ERROR_NONE ? HAL_OK : HAL_ERROR;
 
-    // Allocate I2C Error ISR
+    // Allocate I2C Error ISR (NACK and arbitration lost run on the RX vector)
     cfg.Callback = HAL_I2C_ER_ISR;
-    cfg.Mode = USCIB_MODE_I2C_RX,
-    err = HAL_USCI_Intr_Alloc(&cfg) == USCI_ERROR_NONE ? HAL_OK : HAL_ERROR;
+    cfg.Mode = USCIB_MODE_I2C_RX;
+    if(HAL_USCI_Intr_Alloc(&cfg) != USCI_ERROR_NONE) err = HAL_ERROR;
 
     // Unlock handler
     __HAL_UNLOCK(hi2c);
@@ -436,8 +442,9 @@ uint16_t HAL_I2C_Free_ISR(I2C_HandleTypeDef *hi2c)
        .Module = USCI_MODULE_B
     };
     uint16_t err = HAL_USCI_Intr_Free(&cfg) == USCI_ERROR_NONE ? HAL_OK : HAL_ERROR;
-    cfg.Mode = USCIB_MODE_I2C_RX,
-    err = HAL_USCI_Intr_Free(&cfg) == USCI_ERROR_NONE ? HAL_OK : HAL_ERROR;
+    cfg.Callback = HAL_I2C_ER_ISR;
+    cfg.Mode = USCIB_MODE_I2C_RX;
+    if(HAL_USCI_Intr_Free(&cfg) != USCI_ERROR_NONE) err = HAL_ERROR;
 
     // Unlock handler
     __HAL_UNLOCK(hi2c);
@@ -448,173 +455,304 @@ uint16_t HAL_I2C_Free_ISR(I2C_HandleTypeDef *hi2c)
 uint16_t HAL_I2C_Transmit_IT(I2C_HandleTypeDef *hi2c, I2C_MessageTypeDef *I2C_Message)
 {
     assert_param_ret(IS_I2C_ALL_INSTANCE(hi2c->Instance), I2C_ERROR_INSTANCE);
-    assert_param_ret(!(hi2c->Instance->STAT & UCBBUSY), I2C_ERROR_BUSY);
-    assert_param_ret(hi2c->State==I2C_STATE_IDLE, I2C_ERROR_BUSY); // Redundat?
-    //assert_param_ret(I2C_Message->TxBuffer && I2C_Message->TxCount, I2C_ERROR_ARGIN);
+    assert_param_ret(I2C_Message->TxBuffer && I2C_Message->TxCount, I2C_ERROR_ARGIN);
     assert_param_ret(I2C_Message->DevAddress < 1024, I2C_ERROR_OVADR);
 
-    __HAL_LOCK(hi2c);
-
-    // Set parameters
-    hi2c->TxBuffer = I2C_Message->TxBuffer;
-    hi2c->TxCount = I2C_Message->TxCount;
-    hi2c->State = I2C_STATE_TX;
+    return HAL_I2C_IT_Begin(hi2c, I2C_Message->DevAddress, 0, 0,
+                            (const uint8_t *)I2C_Message->TxBuffer, I2C_Message->TxCount, NULL, 0);
+}
 
-    // Check for 10-bits addressing mode
-    if(I2C_Message->DevAddress > 255)
-    {
-        hi2c->Instance->CTL0 |= UCSLA10;
-    }
 
-    // Set slave address
-    __HAL_I2C_SET_SADDR(hi2c,I2C_Message->DevAddress);
+uint16_t HAL_I2C_TransmitReceive_IT(I2C_HandleTypeDef *hi2c, I2C_MessageTypeDef *I2C_Message)
+{
+    assert_param_ret(IS_I2C_ALL_INSTANCE(hi2c->Instance), I2C_ERROR_INSTANCE);
+    assert_param_ret(!I2C_Message->TxCount || I2C_Message->TxBuffer, I2C_ERROR_ARGIN);
+    assert_param_ret(!I2C_Message->RxCount || I2C_Message->RxBuffer, I2C_ERROR_ARGIN);
+    assert_param_ret(I2C_Message->TxCount || I2C_Message->RxCount, I2C_ERROR_ARGIN);
+    assert_param_ret(I2C_Message->DevAddress < 1024, I2C_ERROR_OVADR);
 
-    // Generate start condition
-    hi2c->Instance->CTL1 |= UCTR | UCTXSTT;
+    return HAL_I2C_IT_Begin(hi2c, I2C_Message->DevAddress, 0, 0,
+                            (const uint8_t *)I2C_Message->TxBuffer, I2C_Message->TxCount,
+                            (uint8_t *)I2C_Message->RxBuffer, I2C_Message->RxCount);
+}
 
-    // Clear flags
-    HAL_I2C_ClearPendingFlags(hi2c, I2C_TXIFG | I2C_RXIFG);
-    __HAL_I2C_ENABLE_IT(hi2c, I2C_TXIE);
 
-    __HAL_UNLOCK(hi2c);
+uint16_t HAL_I2C_Read_Regs_IT(I2C_HandleTypeDef *hi2c, uint8_t Address, uint8_t RegAddress, uint8_t *RegData, uint8_t len)
+{
+    assert_param_ret(IS_I2C_ALL_INSTANCE(hi2c->Instance), I2C_ERROR_INSTANCE);
+    assert_param_ret(RegData && len, I2C_ERROR_ARGIN);
 
-    return I2C_ERROR_NONE;
+    return HAL_I2C_IT_Begin(hi2c, Address, 1, RegAddress, NULL, 0, RegData, len);
 }
 
 
-uint16_t HAL_I2C_TransmitReceive_IT(I2C_HandleTypeDef *hi2c, I2C_MessageTypeDef *I2C_Message)
+uint16_t HAL_I2C_Write_Regs_IT(I2C_HandleTypeDef *hi2c, uint8_t Address, uint8_t RegAddress, const uint8_t *RegData, uint8_t len)
 {
     assert_param_ret(IS_I2C_ALL_INSTANCE(hi2c->Instance), I2C_ERROR_INSTANCE);
-    assert_param_ret(!(hi2c->Instance->STAT & UCBBUSY), I2C_ERROR_BUSY);
-    assert_param_ret(hi2c->State==I2C_STATE_IDLE, I2C_ERROR_BUSY); // Redundat?
-    //assert_param_ret(I2C_Message->TxBuffer && I2C_Message->TxCount, I2C_ERROR_ARGIN);
-    //assert_param_ret(I2C_Message->RxBuffer && I2C_Message->RxCount, I2C_ERROR_ARGIN);
-    assert_param_ret(I2C_Message->DevAddress < 1024, I2C_ERROR_OVADR);
+    assert_param_ret(RegData || !len, I2C_ERROR_ARGIN);
 
-    __HAL_LOCK(hi2c);
+    return HAL_I2C_IT_Begin(hi2c, Address, 1, RegAddress, RegData, len, NULL, 0);
+}
 
-    // Set parameters
-    hi2c->TxBuffer = I2C_Message->TxBuffer;
-    hi2c->TxCount = I2C_Message->TxCount;
-    hi2c->RxBuffer = I2C_Message->RxBuffer;
-    hi2c->RxCount = I2C_Message->RxCount;
-    hi2c->State = I2C_STATE_TX;
 
-    // Check for 10-bits addressing mode
-    if(I2C_Message->DevAddress > 255)
+uint8_t HAL_I2C_IsIdle(I2C_HandleTypeDef *hi2c)
+{
+    return (hi2c->State == I2C_STATE_IDLE);
+}
+
+
+/* Private reference functions -----------------------------------------------*/
+/*
+ * Set up the handle and send the START. The rest of the transfer runs from
+ * HAL_I2C_EV_ISR (TXIFG/RXIFG) and HAL_I2C_ER_ISR (NACKIFG/ALIFG):
+ *
+ *   I2C_STATE_TX: Reg, then TxBuffer, one byte per TXIFG. When TXIFG finds
+ *                 nothing left, the last byte is in the shift register: STOP,
+ *                 or a repeated START as receiver when RxCount is set.
+ *   I2C_STATE_RX: one byte per RXIFG, the STOP is requested while the last
+ *                 byte is being received (so it gets the NACK).
+ *   I2C_STATE_STOP: the STOP goes out, after the last byte written (the
+ *                 slave may still NACK it) or read, or after an error. The
+ *                 USCI has no interrupt for the end of a master STOP:
+ *                 HAL_I2C_IT_StopWait polls UCTXSTP from the deferred call
+ *                 daemon, then the transfer is over (XferEnd, callbacks).
+ *
+ * A NACK (address or data) ends the transfer with a STOP and ErrorCallback.
+ */
+static uint16_t HAL_I2C_IT_Begin(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t RegCount, uint8_t Reg,
+                                 const uint8_t *TxBuffer, uint8_t TxCount, uint8_t *RxBuffer, uint8_t RxCount)
+{
+    I2C_TypeDef *I2Cx = hi2c->Instance;
+
+    uint16_t __InterruptStatus = __get_SR_register() & 0x0008;
+    __disable_interrupt();
+    if(hi2c->State != I2C_STATE_IDLE)
     {
-        hi2c->Instance->CTL0 |= UCSLA10;
+        __bis_SR_register(__InterruptStatus);
+        return I2C_ERROR_BUSY;
     }
 
-    // Set slave address
-    __HAL_I2C_SET_SADDR(hi2c,I2C_Message->DevAddress);
+    // Set parameters
+    hi2c->Reg = Reg;
+    hi2c->RegCount = RegCount;
+    hi2c->TxBuffer = TxBuffer;
+    hi2c->TxCount = TxCount;
+    hi2c->RxBuffer = RxCount ? RxBuffer : NULL;     // NULL: TxCpltCallback at the end
+    hi2c->RxCount = RxCount;
+    hi2c->ErrorCode = I2C_ERROR_NONE;
+
+    // STOP of a polled transfer still going out (an interrupt driven one
+    // ends once its STOP is out)
+    while(I2Cx->CTL1 & UCTXSTP) { }
 
-    // Generate start condition
-    hi2c->Instance->CTL1 |= UCTR | UCTXSTT;
+    // Check for 10-bits addressing mode
+    if(DevAddress > 255) I2Cx->CTL0 |= UCSLA10;
+    else I2Cx->CTL0 &= ~UCSLA10;
 
-    // Clear flags
+    // Set slave address
+    __HAL_I2C_SET_SADDR(hi2c, DevAddress);
+
+    // Clear flags (before the START, which sets TXIFG)
+    I2Cx->STAT &= ~(UCNACKIFG | UCALIFG);
     HAL_I2C_ClearPendingFlags(hi2c, I2C_TXIFG | I2C_RXIFG);
-    __HAL_I2C_ENABLE_IT(hi2c, I2C_TXIE);
+    I2Cx->I2CIE |= UCNACKIE | UCALIE;
 
-    __HAL_UNLOCK(hi2c);
+    if(RegCount || TxCount)
+    {
+        // Generate start condition as transmitter
+        hi2c->State = I2C_STATE_TX;
+        I2Cx->CTL1 |= UCTR | UCTXSTT;
+        __HAL_I2C_ENABLE_IT(hi2c, I2C_TXIE);
+    }
+    else
+    {
+        HAL_I2C_IT_StartRx(hi2c);
+    }
+
+    __bis_SR_register(__InterruptStatus);
 
     return I2C_ERROR_NONE;
 }
 
+// (Repeated) START as receiver
+static void HAL_I2C_IT_StartRx(I2C_HandleTypeDef *hi2c)
+{
+    hi2c->State = I2C_STATE_RX;
+    __HAL_I2C_ENABLE_IT(hi2c, I2C_RXIE);
+    hi2c->Instance->CTL1 &= ~UCTR;      // Switch to receiver
+    HAL_I2C_IT_START(hi2c);             // Send (repeated) start
+
+    if(hi2c->RxCount == 1)
+    {
+        // A single byte needs the STOP while it is being received, that is
+        // as soon as the address is acknowledged: the only wait of the state
+        // machine (the address, and before a repeated start the last byte
+        // written). Two or more bytes are not polled.
+        while(hi2c->Instance->CTL1 & UCTXSTT) { }
+        HAL_I2C_IT_STOP(hi2c);
+    }
+}
+
+// Transfer over: interrupts off, handle idle
+static void HAL_I2C_IT_Idle(I2C_HandleTypeDef *hi2c, uint8_t ErrorCode)
+{
+    __HAL_I2C_DISABLE_IT(hi2c, I2C_TXIE | I2C_RXIE);
+    hi2c->Instance->I2CIE &= ~(UCNACKIE | UCALIE);
+
+    hi2c->RegCount = 0;
+    hi2c->TxCount = 0;
+    hi2c->RxCount = 0;
+    hi2c->ErrorCode = ErrorCode;
+    hi2c->State = I2C_STATE_IDLE;
+}
+
+// Last byte done or error (ISR, STOP requested): the transfer ends once the
+// STOP is out. Waited for out of the ISR, or here when the deferred call
+// queue is full.
+static void HAL_I2C_IT_End(I2C_HandleTypeDef *hi2c)
+{
+    __HAL_I2C_DISABLE_IT(hi2c, I2C_TXIE | I2C_RXIE);
+    HAL_I2C_ClearPendingFlags(hi2c, I2C_TXIFG);
+    hi2c->State = I2C_STATE_STOP;
+
+#if configHAL_USE_UPRTOS == (1) && configUSE_DEFERRED_CALLS == (1)
+    UBaseType_t xDeferWoken = pdFALSE;
+    if( xDeferFunctionCallFromISR(HAL_I2C_IT_StopDeferred, hi2c, &xDeferWoken) ) { portYIELD_FROM_ISR(xDeferWoken); }
+    else HAL_I2C_IT_StopWait(hi2c, 1);
+#else
+    HAL_I2C_IT_StopWait(hi2c, 1);
+#endif
+}
+
+// Transfer over once its STOP is out. Interrupts stay enabled meanwhile,
+// HAL_I2C_ER_ISR records a NACK of the last byte written.
+static void HAL_I2C_IT_StopWait(I2C_HandleTypeDef *hi2c, uint8_t FromISR)
+{
+    I2C_TypeDef *I2Cx = hi2c->Instance;
+    void(*Callback)(void *hi2c);
+
+    while(I2Cx->CTL1 & UCTXSTP) { }
+
+    uint16_t __InterruptStatus = __get_SR_register() & 0x0008;
+    __disable_interrupt();
+
+    // The NACK comes before the STOP, its interrupt may not have run yet
+    if((I2Cx->STAT & I2Cx->I2CIE & UCNACKIFG) && hi2c->ErrorCode == I2C_ERROR_NONE) hi2c->ErrorCode = I2C_ERROR_NACK;
+    I2Cx->STAT &= ~(UCNACKIFG | UCALIFG);
+
+    if(hi2c->ErrorCode != I2C_ERROR_NONE) Callback = hi2c->ErrorCallback;
+    else if(hi2c->RxBuffer != NULL) Callback = hi2c->RxCpltCallback;
+    else Callback = hi2c->TxCpltCallback;
+    HAL_I2C_IT_Idle(hi2c, hi2c->ErrorCode);
+
+    __bis_SR_register(__InterruptStatus);
+
+    // The owner may start the next transfer right here
+    if(hi2c->XferEnd) hi2c->XferEnd(hi2c, FromISR);
 
+    // Callback
+    if(Callback)
+    {
+        if(FromISR) __HAL_USCI_CALLBACK(Callback, hi2c);
+        else Callback(hi2c);
+    }
+}
 
+#if configHAL_USE_UPRTOS == (1) && configUSE_DEFERRED_CALLS == (1)
+static void HAL_I2C_IT_StopDeferred(void *argin)
+{
+    HAL_I2C_IT_StopWait((I2C_HandleTypeDef *)argin, 0);
+}
+#endif
 
 
-void HAL_I2C_EV_ISR(void *argin)
+/* Interrupt service routines ------------------------------------------------*/
+static void HAL_I2C_EV_ISR(void *argin)
 {
     I2C_HandleTypeDef *hi2c = (I2C_HandleTypeDef *)argin;
 
-    if(HAL_I2C_CheckPendingFlag(hi2c,I2C_RXIFG))
-    {
-        //Must read from UCB0RXBUF
-        uint8_t rx_val = hi2c->Instance->RXBUF;
+    // The vector is shared with the other USCI module
+    uint8_t pending = IFG2 & IE2 & (I2C_TXIFG | I2C_RXIFG);
 
-        // RX Handler
-        if(hi2c->State == I2C_STATE_RX)
-        {
-            if(hi2c->RxCount)
-            {
-                *hi2c->RxBuffer++ = rx_val;
-                hi2c->RxCount--;
+    if(pending & I2C_RXIFG)
+    {
+        // Must read from UCB0RXBUF (clears the flag)
+        uint8_t rx_val = HAL_I2C_IT_Read(hi2c);
 
-                if (hi2c->RxCount == 1)
-                {
-                    // Send stop bit
-                    hi2c->Instance->CTL1 |= UCTXSTP;
-                }
-                else if (!hi2c->RxCount)
-                {
-                    // Disable rx interrupt
-                    __HAL_I2C_DISABLE_IT(hi2c,I2C_RXIE);
-                    hi2c->State = I2C_STATE_IDLE;
+        *hi2c->RxBuffer++ = rx_val;
+        hi2c->RxCount--;
 
-                    // Callback
-                    if(hi2c->RxCpltCallback) hi2c->RxCpltCallback(hi2c);
-                }
-            }
+        if(hi2c->RxCount == 1)
+        {
+            // The byte being received is the last one: NACK and STOP after it
+            HAL_I2C_IT_STOP(hi2c);
+        }
+        else if(!hi2c->RxCount)
+        {
+            HAL_I2C_IT_End(hi2c);
         }
     }
-    else if(HAL_I2C_CheckPendingFlag(hi2c,I2C_TXIFG))
+    else if(pending & I2C_TXIFG)
     {
-        // TX
-        if(hi2c->State == I2C_STATE_TX)
+        if(hi2c->RegCount)
         {
-            if(hi2c->TxCount)
-            {
-                hi2c->Instance->TXBUF = *hi2c->TxBuffer++;
-                hi2c->TxCount--;
-            }
-
-            // End of tx
-            if (!hi2c->TxCount)
-            {
-                // Disable tx interrupt
-                __HAL_I2C_DISABLE_IT(hi2c,I2C_TXIE);
-
-                // Check if it is expected rx data
-                if(hi2c->RxCount)
-                {
-                    hi2c->State = I2C_STATE_RX;
-                    __HAL_I2C_ENABLE_IT(hi2c, I2C_RXIE);
-                    hi2c->Instance->CTL1 &= ~UCTR;      // Switch to receiver
-                    hi2c->Instance->CTL1 |= UCTXSTT;    // Send repeated start
-                    if (hi2c->RxCount == 1)
-                    {
-                        // Must send stop since this is the N-1 byte
-                        while(hi2c->Instance->CTL1 & UCTXSTT);
-                        hi2c->Instance->CTL1 |= UCTXSTP;      // Send stop condition
-                    }
-                }
-                else
-                {
-                    hi2c->State = I2C_STATE_IDLE;
-                }
-
-                // Callback
-                if(hi2c->TxCpltCallback) hi2c->TxCpltCallback(hi2c);
-            }
+            HAL_I2C_IT_Write(hi2c, hi2c->Reg);
+            hi2c->RegCount = 0;
+        }
+        else if(hi2c->TxCount)
+        {
+            HAL_I2C_IT_Write(hi2c, *hi2c->TxBuffer++);
+            hi2c->TxCount--;
+        }
+        else if(hi2c->RxCount)
+        {
+            // Write part done: read part after a repeated start
+            __HAL_I2C_DISABLE_IT(hi2c, I2C_TXIE);
+            HAL_I2C_ClearPendingFlags(hi2c, I2C_TXIFG);
+            HAL_I2C_IT_StartRx(hi2c);
+        }
+        else
+        {
+            // End of tx: STOP once the last byte is out, which the slave
+            // may still NACK
+            HAL_I2C_IT_STOP(hi2c);
+            HAL_I2C_IT_End(hi2c);
         }
     }
 }
 
 
-void HAL_I2C_ER_ISR(void *argin)
+static void HAL_I2C_ER_ISR(void *argin)
 {
-    if (UCB0STAT & UCNACKIFG)
-    {
-        UCB0STAT &= ~UCNACKIFG;
-    }
-    else if (UCB0STAT & UCSTPIFG)
+    I2C_HandleTypeDef *hi2c = (I2C_HandleTypeDef *)argin;
+    I2C_TypeDef *I2Cx = hi2c->Instance;
+
+    // The vector is shared with the other USCI module
+    uint8_t pending = I2Cx->STAT & I2Cx->I2CIE & (UCNACKIFG | UCALIFG);
+    if(!pending) return;
+
+    I2Cx->STAT &= ~(UCNACKIFG | UCALIFG);
+    HAL_I2C_ClearPendingFlags(hi2c, I2C_TXIFG | I2C_RXIFG);
+
+    if(pending & UCNACKIFG)
     {
-        UCB0STAT &= ~(UCSTTIFG + UCSTPIFG + UCNACKIFG);
+        // Address or data not acknowledged: release the bus. After the
+        // last byte written the STOP is already requested.
+        if(hi2c->State != I2C_STATE_STOP) HAL_I2C_IT_STOP(hi2c);
+        hi2c->ErrorCode = I2C_ERROR_NACK;
     }
-    else if (UCB0STAT & UCSTTIFG)
+    else
     {
-        UCB0STAT &= ~(UCSTTIFG);
+        // Arbitration lost: the USCI turned slave, the other master owns the
+        // bus. Master again for the next transfer (UCSWRST also drops a
+        // requested STOP).
+        I2Cx->CTL1 |= UCSWRST;
+        I2Cx->CTL0 |= UCMST;
+        I2Cx->CTL1 &= ~UCSWRST;
+        hi2c->ErrorCode = I2C_ERROR_ARLO;
     }
+
+    // Ends with ErrorCallback once the STOP is out, already on its way
+    // after the last byte written
+    if(hi2c->State != I2C_STATE_STOP) HAL_I2C_IT_End(hi2c);
 }
@@ -0,0 +1,335 @@
+/**
+  ******************************************************************************
+  * @file       msp430_hal_i2cbus.c
+  * @author     Fernando Hermosillo Reynoso
+  * @brief      Source file of the shared I2C bus (transaction scheduler) HAL
+  *             module.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 Universidad Panamericana.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <Drivers/msp430_hal_i2cbus.h>
+#include <stddef.h>
+
+
+/* Private types -------------------------------------------------------------*/
+
+
+/* Private constants ---------------------------------------------------------*/
+
+
+/* Private macros ------------------------------------------------------------*/
+
+
+/* Private variables ---------------------------------------------------------*/
+
+
+/* Private functions ---------------------------------------------------------*/
+static uint16_t HAL_I2CBUS_Queue(I2CBUS_HandleTypeDef *hbus, I2CBUS_TransactionTypeDef *xfer, uint8_t FromISR);
+static I2CBUS_TransactionTypeDef *HAL_I2CBUS_Start(I2CBUS_HandleTypeDef *hbus);
+static uint16_t HAL_I2CBUS_Begin(I2CBUS_HandleTypeDef *hbus, I2CBUS_TransactionTypeDef *xfer);
+static void HAL_I2CBUS_Finish(I2CBUS_TransactionTypeDef *xfer, uint8_t FromISR);
+static void HAL_I2CBUS_FinishAll(I2CBUS_TransactionTypeDef *xfer, uint8_t FromISR);
+static void HAL_I2CBUS_XferEnd(void *argin, uint8_t FromISR);
+
+
+/* Reference functions -------------------------------------------------------*/
+/**
+ * @brief Share an I2C master between several devices and tasks. The
+ *        transactions run back to back, the slave address (UCB0I2CSA)
+ *        only changes between two of them. The next one starts once the
+ *        STOP of the previous one is out (the USCI has no interrupt for
+ *        it, the I2C engine waits for it in the deferred call daemon).
+ * @param I2Cx Instance set up with HAL_I2C_Init as a master, used only
+ *        through the bus from now on
+ */
+uint16_t HAL_I2CBUS_Init(I2CBUS_HandleTypeDef *hbus, I2C_TypeDef *I2Cx)
+{
+    assert_param_ret(hbus != NULL, HAL_ERROR);
+    assert_param_ret(IS_I2C_ALL_INSTANCE(I2Cx), HAL_ERROR);
+
+    hbus->Head = NULL;
+    hbus->Tail = NULL;
+
+    // Interrupt driven engine: the end of each transfer starts the next one
+    hbus->hi2c.Instance = I2Cx;
+    hbus->hi2c.TxCpltCallback = NULL;
+    hbus->hi2c.RxCpltCallback = NULL;
+    hbus->hi2c.ErrorCallback = NULL;
+    hbus->hi2c.XferEnd = HAL_I2CBUS_XferEnd;
+    hbus->hi2c.State = I2C_STATE_IDLE;
+    hbus->hi2c.Lock = HAL_UNLOCKED;
+
+    return (HAL_I2C_Alloc_ISR(&hbus->hi2c) == HAL_OK) ? HAL_OK : HAL_ERROR;
+}
+
+/**
+ * @brief Queue a transaction, and the ones linked after it through Next
+ *        (they run back to back). Does not wait: Status leaves
+ *        I2CBUS_PENDING, then Task is notified and the Callback runs.
+ *        From a task, HAL_I2CBUS_SubmitFromISR from an ISR.
+ * @return HAL_OK, HAL_BUSY if a transaction is still pending, HAL_ERROR on bad parameters
+ */
+uint16_t HAL_I2CBUS_Submit(I2CBUS_HandleTypeDef *hbus, I2CBUS_TransactionTypeDef *xfer)
+{
+    return HAL_I2CBUS_Queue(hbus, xfer, 0);
+}
+
+/**
+ * @brief HAL_I2CBUS_Submit from an ISR
+ */
+uint16_t HAL_I2CBUS_SubmitFromISR(I2CBUS_HandleTypeDef *hbus, I2CBUS_TransactionTypeDef *xfer)
+{
+    return HAL_I2CBUS_Queue(hbus, xfer, 1);
+}
+
+/**
+ * @brief 1 when no transaction is queued or on the bus
+ */
+uint8_t HAL_I2CBUS_IsIdle(I2CBUS_HandleTypeDef *hbus)
+{
+    return (hbus->Head == NULL);
+}
+
+#if HAL_I2CBUS_USE_NOTIFY == (1)
+/**
+ * @brief Submit one transaction (Next NULL) and sleep until the bus ends it
+ * @param Timeout Ticks to wait, portMAX_DELAY waits forever
+ * @return HAL_OK, HAL_ERROR on bad parameters or a failed transaction
+ *         (ErrorCode), HAL_BUSY on timeout: a transaction still queued is
+ *         withdrawn (I2CBUS_IDLE), one already on the bus stays
+ *         I2CBUS_PENDING until it ends
+ */
+uint16_t HAL_I2CBUS_Transfer(I2CBUS_HandleTypeDef *hbus, I2CBUS_TransactionTypeDef *xfer, TickType_t Timeout)
+{
+    uint16_t bus_err;
+
+    assert_param_ret(xfer != NULL, HAL_ERROR);
+    assert_param_ret(xfer->Next == NULL, HAL_ERROR);
+
+    // Drop a notification left by an earlier timeout
+    (void)usTaskNotifyTakeIndexed(configHAL_I2CBUS_NOTIFY_INDEX, pdTRUE, 0);
+
+    xfer->Task = xTaskGetCurrentTaskHandle();
+    bus_err = HAL_I2CBUS_Submit(hbus, xfer);
+    if(bus_err != HAL_OK)
+    {
+        xfer->Task = NULL;
+        return bus_err;
+    }
+
+    if(usTaskNotifyTakeIndexed(configHAL_I2CBUS_NOTIFY_INDEX, pdTRUE, Timeout) == 0)
+    {
+        uint16_t __InterruptStatus = __get_SR_register() & 0x0008;
+        __disable_interrupt();
+        xfer->Task = NULL;
+        if(xfer->Status == I2CBUS_PENDING && xfer != hbus->Head)
+        {
+            // Still queued: unlink it
+            I2CBUS_TransactionTypeDef *prev = hbus->Head;
+            while(prev->Next != xfer) prev = prev->Next;
+            prev->Next = xfer->Next;
+            if(hbus->Tail == xfer) hbus->Tail = prev;
+            xfer->Next = NULL;
+            xfer->Status = I2CBUS_IDLE;
+        }
+        __bis_SR_register(__InterruptStatus);
+
+        if(xfer->Status < I2CBUS_DONE) return HAL_BUSY;
+    }
+
+    return (xfer->Status == I2CBUS_DONE) ? HAL_OK : HAL_ERROR;
+}
+#endif
+
+
+/* Private reference functions -----------------------------------------------*/
+static uint16_t HAL_I2CBUS_Queue(I2CBUS_HandleTypeDef *hbus, I2CBUS_TransactionTypeDef *xfer, uint8_t FromISR)
+{
+    I2CBUS_TransactionTypeDef *last;
+    I2CBUS_TransactionTypeDef *refused = NULL;
+
+    assert_param_ret(hbus != NULL, HAL_ERROR);
+    assert_param_ret(xfer != NULL, HAL_ERROR);
+
+    // Check the whole chain before queueing any of it
+    for(last = xfer; ; last = last->Next)
+    {
+        assert_param_ret(last->DevAddress < 1024, HAL_ERROR);
+        assert_param_ret(!last->TxSize || last->pTxData != NULL, HAL_ERROR);
+        assert_param_ret(!last->RxSize || last->pRxData != NULL, HAL_ERROR);
+        if(last->Flags & I2CBUS_FLAG_REG)
+        {
+            // HAL_I2C_Read_Regs_IT or HAL_I2C_Write_Regs_IT
+            assert_param_ret(last->DevAddress < 256, HAL_ERROR);
+            assert_param_ret(!(last->TxSize && last->RxSize), HAL_ERROR);
+        }
+        else
+        {
+            assert_param_ret(last->TxSize || last->RxSize, HAL_ERROR);
+        }
+        if(last->Status == I2CBUS_PENDING) return HAL_BUSY;
+        if(last->Next == NULL) break;
+    }
+    for(last = xfer; ; last = last->Next)
+    {
+        last->ErrorCode = I2C_ERROR_NONE;
+        last->Status = I2CBUS_PENDING;
+        if(last->Next == NULL) break;
+    }
+
+    uint16_t __InterruptStatus = __get_SR_register() & 0x0008;
+    __disable_interrupt();
+    if(hbus->Head == NULL)
+    {
+        // Bus idle: start right away
+        hbus->Head = xfer;
+        hbus->Tail = last;
+        refused = HAL_I2CBUS_Start(hbus);
+    }
+    else
+    {
+        hbus->Tail->Next = xfer;
+        hbus->Tail = last;
+    }
+    __bis_SR_register(__InterruptStatus);
+
+    HAL_I2CBUS_FinishAll(refused, FromISR);
+
+    return HAL_OK;
+}
+
+// Put the transaction at Head on the bus (interrupts masked). Returns the
+// ones refused on the way, for HAL_I2CBUS_FinishAll once interrupts are
+// back: their callbacks may submit.
+static I2CBUS_TransactionTypeDef *HAL_I2CBUS_Start(I2CBUS_HandleTypeDef *hbus)
+{
+    I2CBUS_TransactionTypeDef *xfer;
+    I2CBUS_TransactionTypeDef *refused = NULL;
+
+    // The engine refuses a transaction only if hi2c is used outside the
+    // bus: it fails and the next one is tried
+    while((xfer = hbus->Head) != NULL)
+    {
+        xfer->ErrorCode = HAL_I2CBUS_Begin(hbus, xfer);
+        if(xfer->ErrorCode == I2C_ERROR_NONE) break;
+
+        hbus->Head = xfer->Next;
+        xfer->Next = refused;
+        refused = xfer;
+    }
+
+    return refused;
+}
+
+static uint16_t HAL_I2CBUS_Begin(I2CBUS_HandleTypeDef *hbus, I2CBUS_TransactionTypeDef *xfer)
+{
+    if(xfer->Flags & I2CBUS_FLAG_REG)
+    {
+        if(xfer->RxSize)
+        {
+            return HAL_I2C_Read_Regs_IT(&hbus->hi2c, (uint8_t)xfer->DevAddress, xfer->Reg, xfer->pRxData, xfer->RxSize);
+        }
+        return HAL_I2C_Write_Regs_IT(&hbus->hi2c, (uint8_t)xfer->DevAddress, xfer->Reg, xfer->pTxData, xfer->TxSize);
+    }
+
+    // The engine copies the message
+    I2C_MessageTypeDef msg;
+    msg.TxBuffer = xfer->pTxData;
+    msg.TxCount = xfer->TxSize;
+    msg.RxBuffer = xfer->pRxData;
+    msg.RxCount = xfer->RxSize;
+    msg.DevAddress = xfer->DevAddress;
+    return HAL_I2C_TransmitReceive_IT(&hbus->hi2c, &msg);
+}
+
+// Hand a transaction (off the queue, ErrorCode set) back to its requester.
+// Interrupts enabled, or in an ISR (FromISR).
+static void HAL_I2CBUS_Finish(I2CBUS_TransactionTypeDef *xfer, uint8_t FromISR)
+{
+    I2CBUSCallback_t Callback = xfer->Callback;
+#if HAL_I2CBUS_USE_NOTIFY == (1)
+    TaskHandle_t xTask = xfer->Task;
+
+    xfer->Task = NULL;
+#endif
+
+    xfer->Next = NULL;
+    xfer->Status = (xfer->ErrorCode == I2C_ERROR_NONE) ? I2CBUS_DONE : I2CBUS_ERROR;
+
+    if(FromISR)
+    {
+#if HAL_I2CBUS_USE_NOTIFY == (1)
+        if(xTask != NULL)
+        {
+            UBaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+            vTaskNotifyGiveIndexedFromISR(xTask, configHAL_I2CBUS_NOTIFY_INDEX, &xHigherPriorityTaskWoken);
+            portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+        }
+#endif
+        if(Callback) __HAL_USCI_CALLBACK(Callback, xfer);
+    }
+    else
+    {
+        // Task level: the notification switches to the requester right
+        // away if it has the higher priority
+#if HAL_I2CBUS_USE_NOTIFY == (1)
+        if(xTask != NULL) (void)xTaskNotifyGiveIndexed(xTask, configHAL_I2CBUS_NOTIFY_INDEX);
+#endif
+        if(Callback) Callback(xfer);
+    }
+}
+
+// Finish a list linked through Next
+static void HAL_I2CBUS_FinishAll(I2CBUS_TransactionTypeDef *xfer, uint8_t FromISR)
+{
+    I2CBUS_TransactionTypeDef *next;
+
+    while(xfer != NULL)
+    {
+        next = xfer->Next;
+        HAL_I2CBUS_Finish(xfer, FromISR);
+        xfer = next;
+    }
+}
+
+
+/* Interrupt service routines ------------------------------------------------*/
+// End of the transfer at Head, once its STOP is out: in the I2C ISR, or in
+// the deferred call daemon (FromISR 0)
+static void HAL_I2CBUS_XferEnd(void *argin, uint8_t FromISR)
+{
+    I2CBUS_HandleTypeDef *hbus = (I2CBUS_HandleTypeDef *)argin;     // hi2c is the first member
+    I2CBUS_TransactionTypeDef *xfer;
+    I2CBUS_TransactionTypeDef *refused;
+
+    uint16_t __InterruptStatus = __get_SR_register() & 0x0008;
+    __disable_interrupt();
+    xfer = hbus->Head;
+    if(xfer == NULL)
+    {
+        __bis_SR_register(__InterruptStatus);
+        return;
+    }
+
+    xfer->ErrorCode = hbus->hi2c.ErrorCode;
+    hbus->Head = xfer->Next;
+
+    // Next one first, the bus does not wait for the requester
+    refused = HAL_I2CBUS_Start(hbus);
+    __bis_SR_register(__InterruptStatus);
+
+    HAL_I2CBUS_Finish(xfer, FromISR);
+    HAL_I2CBUS_FinishAll(refused, FromISR);
+}
@@ -30,6 +30,15 @@
 #define NULL    ((void *)(0))
 #endif
 
+/* Private macros ------------------------------------------------------------*/
+// Block transfer: wait for a flag of IFG2, write TXBUF, read RXBUF
+#define __SPI_WAIT(FLAG)        do { } while(!(IFG2 & (FLAG)))
+#define __SPI_TX()              do { SPIx->TXBUF = *pTxData; pTxData += TxStep; } while(0)
+#define __SPI_RX()              do { *pRxData++ = SPIx->RXBUF; } while(0)
+
+// Pipelined step: queue the next byte, then read the one on the bus
+#define __SPI_STEP()            do { __SPI_WAIT(TxIfg); __SPI_TX(); __SPI_WAIT(RxIfg); __SPI_RX(); } while(0)
+
 /* Private variables ---------------------------------------------------------*/
 
 static void HAL_SPI_TXISR(void *argin);
@@ -48,6 +57,14 @@ void HAL_SPI_Init(SPI_HandleTypeDef *hspi, SPI_InitTypeDef *SPI_InitStruct)
     assert_param(IS_SPI_MODE(SPI_InitStruct->Mode));
 
     // SPI config
+    // No transfer running
+    hspi->TxXferSize = 0;
+    hspi->RxXferSize = 0;
+    hspi->Duplex = 0;
+#if HAL_SPI_USE_BLOCKING == (1)
+    hspi->Waiter = NULL;
+#endif
+
     // USCI logic held in reset state
     hspi->Instance->CTL1 = UCSWRST;
 
@@ -96,19 +113,11 @@ void HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Si
     // Assert
     assert_param(IS_SPI_ALL_INSTANCE(hspi->Instance));
     assert_param(pData != NULL);
-    // Chip select (active high)
-    //P1OUT |= SPI_CS_Pin;
 
-    // Transmit data
-    while(Size--)
-    {
-        while (__HAL_SPI_GET_TX_FLAG(hspi)); // USCI_A0 TX buffer ready?
-        hspi->Instance->TXBUF = *pData--; // Send data over SPI to Slave
-    }
-
-    // Chip unselect (active low)
-    //P1OUT &= ~SPI_CS_Pin;
+    // Transmit data, the received bytes are dropped
+    HAL_SPI_TransmitReceive_Block(hspi, pData, NULL, Size);
 }
+
 void HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size)
 {
     // Assert
@@ -133,24 +142,121 @@ void HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi, const uint8_t *pTxData, ui
 {
     // Assert
     assert_param(IS_SPI_ALL_INSTANCE(hspi->Instance));
-
-    // TODO: Must be performed externally?
-    // Chip select (active high)
-    //P1OUT |= SPI_CS_Pin;
+    assert_param(pTxData != NULL);
+    assert_param(pRxData != NULL);
 
     // Transmit&Receive data
-    while(Size--)
+    HAL_SPI_TransmitReceive_Block(hspi, pTxData, pRxData, Size);
+}
+
+/**
+ * @brief Full-duplex block transfer (master). The next byte is written to
+ *        TXBUF while the current one shifts, so the bytes go out back to
+ *        back instead of one at a time.
+ * @param pTxData Bytes to send, NULL sends SPI_DUMMY_BYTE (e.g. to read a flash)
+ * @param pRxData Received bytes, NULL drops them (e.g. to write a display)
+ * @note  Returns when the last byte is off the bus (UCBUSY cleared), CS can
+ *        be released right away. While receiving, interrupts are masked by
+ *        groups of about configHAL_SPI_MASK_CYCLES BRCLK cycles (the group
+ *        size follows UCBRx), so an ISR cannot make RXBUF overrun. Below
+ *        UCBRx = 2 a byte is shorter than the RXBUF read, and from a byte
+ *        longer than configHAL_SPI_MASK_CYCLES no masking is worth it: one
+ *        byte at a time is kept on the bus. See tools/spitiming.
+ */
+uint16_t HAL_SPI_TransmitReceive_Block(SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint8_t *pRxData, uint16_t Size)
+{
+    // Assert
+    assert_param_ret(IS_SPI_ALL_INSTANCE(hspi->Instance), HAL_ERROR);
+
+    SPI_TypeDef *SPIx = hspi->Instance;
+    const uint16_t Prescaler = ((uint16_t)SPIx->BR1 << 8) | SPIx->BR0;
+    const uint16_t Group = (Prescaler < 2) ? 0 : (configHAL_SPI_MASK_CYCLES / 8) / Prescaler;     // Bytes per masked group
+    const uint8_t TxIfg = (SPIx == SPI1) ? UCA0TXIFG : UCB0TXIFG;
+    const uint8_t RxIfg = (SPIx == SPI1) ? UCA0RXIFG : UCB0RXIFG;
+    const uint8_t Dummy = SPI_DUMMY_BYTE;
+    uint16_t TxStep = 1;
+    volatile uint8_t Discard;
+
+    if(pTxData == NULL)
     {
-        while (__HAL_SPI_GET_TX_FLAG(hspi)); // TX buffer ready?
-        hspi->Instance->TXBUF = *pTxData--; // Send data over SPI to Slave
+        pTxData = &Dummy;
+        TxStep = 0;
+    }
 
-        while (__HAL_SPI_GET_RX_FLAG(hspi)); // RX buffer ready?
-        *pRxData++ = hspi->Instance->RXBUF; // Store received data
+    // Previous transfer done, no stale byte in RXBUF
+    while(SPIx->STAT & USCI_STAT_BUSY_M) { }
+    Discard = SPIx->RXBUF;
+
+    if(pRxData == NULL)
+    {
+        // Transmit only: TXBUF is refilled as soon as it empties
+        while(Size >= SPI_BLOCK_UNROLL)
+        {
+            __SPI_WAIT(TxIfg); __SPI_TX();
+            __SPI_WAIT(TxIfg); __SPI_TX();
+            __SPI_WAIT(TxIfg); __SPI_TX();
+            __SPI_WAIT(TxIfg); __SPI_TX();
+            Size -= SPI_BLOCK_UNROLL;
+        }
+        while(Size--)
+        {
+            __SPI_WAIT(TxIfg); __SPI_TX();
+        }
+    }
+    else if(Group == 0)
+    {
+        // One byte on the bus at a time, interrupts enabled
+        while(Size--)
+        {
+            __SPI_WAIT(TxIfg); __SPI_TX();
+            __SPI_WAIT(RxIfg); __SPI_RX();
+        }
     }
+    else if(Size)
+    {
+        uint16_t __InterruptStatus = __get_SR_register() & 0x0008;
+        __disable_interrupt();
+        if(__InterruptStatus) { __HAL_TRACE_MASK_BEGIN(); }
 
-    // Chip unselect (active low)
-    // TODO: Must be performed externally
-    //P1OUT &= ~SPI_CS_Pin;
+        // First byte on the bus, Size counts the bytes left to queue
+        __SPI_WAIT(TxIfg); __SPI_TX();
+        Size--;
+
+        while(Size >= Group)
+        {
+            uint16_t Step;
+            for(Step = Group; Step; Step--) __SPI_STEP();
+            Size -= Group;
+
+            // One byte in flight and TXBUF empty: an interrupt taken here
+            // delays the transfer but cannot overrun RXBUF
+            if(__InterruptStatus)
+            {
+                __HAL_TRACE_MASK_END();
+                __bis_SR_register(__InterruptStatus);
+                __no_operation();
+                __disable_interrupt();
+                __HAL_TRACE_MASK_BEGIN();
+            }
+        }
+        while(Size--)
+        {
+            __SPI_STEP();
+        }
+
+        // Last byte
+        __SPI_WAIT(RxIfg); __SPI_RX();
+
+        if(__InterruptStatus) { __HAL_TRACE_MASK_END(); }
+        __bis_SR_register(__InterruptStatus);
+    }
+
+    // Last byte off the bus, RXBUF left empty (clears UCOE of a transmit only)
+    while(SPIx->STAT & USCI_STAT_BUSY_M) { }
+    Discard = SPIx->RXBUF;
+    UNUSED(Discard);
+
+    return HAL_OK;
 }
 
 
@@ -240,6 +346,7 @@ uint16_t HAL_SPI_Receive_IT(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Si
     // Set parameters
     hspi->pRxBuffPtr = pData;
     hspi->RxXferSize = Size;
+    hspi->Duplex = 0;
 
     // Enable interrupts
     __HAL_SPI_CLEAR_RX_FLAG(hspi);
@@ -254,32 +361,98 @@ uint16_t HAL_SPI_TransmitReceive_IT(SPI_HandleTypeDef *hspi, uint8_t *pTxData, u
 {
     // Assert
     assert_param_ret(IS_SPI_ALL_INSTANCE(hspi->Instance), HAL_ERROR);
+    assert_param_ret(pTxData != NULL && pRxData != NULL && Size != 0, HAL_ERROR);
 
     __HAL_LOCK(hspi);
 
+    // A transfer is still running
+    if(hspi->TxXferSize || hspi->RxXferSize)
+    {
+        __HAL_UNLOCK(hspi);
+        return HAL_BUSY;
+    }
+
     // Set parameters
     hspi->pTxBuffPtr = pTxData;
     hspi->TxXferSize = Size;
     hspi->pRxBuffPtr = pRxData;
     hspi->RxXferSize = Size;
+    hspi->Duplex = 1;
 
-    // Enable interrupts
-    __HAL_SPI_CLEAR_TX_FLAG(hspi);
+    // Enable interrupts: only RX, HAL_SPI_RXISR sends the next byte when
+    // one arrives. TX never runs ahead of RX, so RXBUF cannot overrun
+    // however late the RX interrupt is served.
     __HAL_SPI_CLEAR_RX_FLAG(hspi);
-    __HAL_SPI_ENABLE_TX_IT(hspi);
     __HAL_SPI_ENABLE_RX_IT(hspi);
+    while(__HAL_SPI_GET_TX_FLAG(hspi)) { }
+    hspi->Instance->TXBUF = *hspi->pTxBuffPtr++;
+    hspi->TxXferSize--;
 
     __HAL_UNLOCK(hspi);
 
     return HAL_OK;
 }
 
+#if HAL_SPI_USE_BLOCKING == (1)
+/**
+ * @brief Full-duplex transfer through HAL_SPI_TransmitReceive_IT, the
+ *        calling task sleeps until HAL_SPI_RXISR has the last byte.
+ * @param Timeout Ticks to wait, portMAX_DELAY waits forever
+ * @return HAL_OK, HAL_BUSY on timeout (the transfer is stopped) or if a
+ *         transfer is running, HAL_ERROR on bad parameters
+ * @note  The RX interrupt must be registered with HAL_SPI_RegisterCallback
+ *        (HAL_SPI_CB_TXRX_COMPLETE_ID, the callback may be NULL)
+ */
+uint16_t HAL_SPI_TransmitReceive_Blocking(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, TickType_t Timeout)
+{
+    uint16_t spi_err = HAL_OK;
+
+    // Assert
+    assert_param_ret(IS_SPI_ALL_INSTANCE(hspi->Instance), HAL_ERROR);
+    if(Size == 0) return HAL_OK;
+
+    // Drop a notification left by an earlier timeout
+    (void)usTaskNotifyTakeIndexed(configHAL_SPI_NOTIFY_INDEX, pdTRUE, 0);
+
+    hspi->Waiter = xTaskGetCurrentTaskHandle();
+    spi_err = HAL_SPI_TransmitReceive_IT(hspi, pTxData, pRxData, Size);
+    if(spi_err != HAL_OK)
+    {
+        hspi->Waiter = NULL;
+        return spi_err;
+    }
+
+    if(usTaskNotifyTakeIndexed(configHAL_SPI_NOTIFY_INDEX, pdTRUE, Timeout) == 0)
+    {
+        // Timeout: stop the transfer, unless the last byte came meanwhile
+        uint16_t __InterruptStatus = __get_SR_register() & 0x0008;
+        __disable_interrupt();
+        if(hspi->RxXferSize)
+        {
+            __HAL_SPI_DISABLE_RX_IT(hspi);
+            hspi->TxXferSize = 0;
+            hspi->RxXferSize = 0;
+            hspi->Duplex = 0;
+            spi_err = HAL_BUSY;
+        }
+        hspi->Waiter = NULL;
+        __bis_SR_register(__InterruptStatus);
+    }
+
+    return spi_err;
+}
+#endif
 
 
 static void HAL_SPI_TXISR(void *argin)
 {
     SPI_HandleTypeDef *hspi = (SPI_HandleTypeDef *)argin;
 
+    // The vector is shared with the other USCI module. UCxTXIFG stays set
+    // while TXBUF is free, so only a transfer that enabled the TX interrupt
+    // (HAL_SPI_Transmit_IT) is served: HAL_SPI_RXISR paces the full-duplex one
+    if(!__HAL_SPI_GET_TX_IT(hspi) || __HAL_SPI_GET_TX_FLAG(hspi)) return;
+
     // Transmit
     if(hspi->TxXferSize)
     {
@@ -288,7 +461,7 @@ static void HAL_SPI_TXISR(void *argin)
         if(!hspi->TxXferSize)
         {
             __HAL_SPI_DISABLE_TX_IT(hspi);
-            if(hspi->TxCpltCallback) hspi->TxCpltCallback(hspi);
+            if(hspi->TxCpltCallback) __HAL_USCI_CALLBACK(hspi->TxCpltCallback, hspi);
         }
     }
 }
@@ -297,15 +470,43 @@ static void HAL_SPI_RXISR(void *argin)
 {
     SPI_HandleTypeDef *hspi = (SPI_HandleTypeDef *)argin;
 
+    // The vector is shared with the other USCI module
+    if(__HAL_SPI_GET_RX_FLAG(hspi)) return;
+
     // Receive
     if(hspi->RxXferSize)
     {
         *hspi->pRxBuffPtr++ = hspi->Instance->RXBUF;
         hspi->RxXferSize--;
+
+        // Full-duplex (HAL_SPI_TransmitReceive_IT): next byte out
+        if(hspi->TxXferSize)
+        {
+            hspi->Instance->TXBUF = *hspi->pTxBuffPtr++;
+            hspi->TxXferSize--;
+        }
+
         if(!hspi->RxXferSize)
         {
             __HAL_SPI_DISABLE_RX_IT(hspi);
-            if(hspi->RxCpltCallback) hspi->RxCpltCallback(hspi);
+            if(hspi->Duplex)
+            {
+                hspi->Duplex = 0;
+                if(hspi->TxRxCpltCallback) __HAL_USCI_CALLBACK(hspi->TxRxCpltCallback, hspi);
+            }
+            else if(hspi->RxCpltCallback) __HAL_USCI_CALLBACK(hspi->RxCpltCallback, hspi);
+
+#if HAL_SPI_USE_BLOCKING == (1)
+            if(hspi->Waiter != NULL)
+            {
+                UBaseType_t xHigherPriorityTaskWoken = pdFALSE;
+                TaskHandle_t xWaiter = hspi->Waiter;
+
+                hspi->Waiter = NULL;
+                vTaskNotifyGiveIndexedFromISR(xWaiter, configHAL_SPI_NOTIFY_INDEX, &xHigherPriorityTaskWoken);
+                portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+            }
+#endif
         }
     }
 }
@@ -0,0 +1,246 @@
+/**
+  ******************************************************************************
+  * @file       msp430_hal_spibus.c
+  * @author     Fernando Hermosillo Reynoso
+  * @brief      Source file of the shared SPI bus (transaction queue) HAL module.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 Universidad Panamericana.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <Drivers/msp430_hal_spibus.h>
+#include <Drivers/usci_reg.h>
+#include <stddef.h>
+
+
+/* Private types -------------------------------------------------------------*/
+
+
+/* Private constants ---------------------------------------------------------*/
+#define SPIBUS_CTL0_MODE_M      (0x03 << USCI_CTL0_CPOL_S)     // UCCKPH | UCCKPL
+
+#if configHAL_SPIBUS_ISR_BURST < 1 || configHAL_SPIBUS_ISR_BURST > 255
+#error "configHAL_SPIBUS_ISR_BURST must be between 1 and 255"
+#endif
+
+
+/* Private macros ------------------------------------------------------------*/
+#define __SPIBUS_CS_ASSERT(__DEV__)     HAL_GPIO_WritePin((__DEV__)->CS_Port, (__DEV__)->CS_Pin, (__DEV__)->CS_Active)
+#define __SPIBUS_CS_RELEASE(__DEV__)    HAL_GPIO_WritePin((__DEV__)->CS_Port, (__DEV__)->CS_Pin, !(__DEV__)->CS_Active)
+
+
+/* Private variables ---------------------------------------------------------*/
+
+
+/* Private functions ---------------------------------------------------------*/
+static void HAL_SPIBUS_Start(SPIBUS_HandleTypeDef *hbus);
+static void HAL_SPIBUS_Complete(SPIBUS_HandleTypeDef *hbus);
+static void HAL_SPIBUS_RXISR(void *argin);
+
+
+/* Reference functions -------------------------------------------------------*/
+/**
+ * @brief Share an SPI master between several devices. The bus takes the RX
+ *        interrupt of the instance (HAL_SPI_RegisterCallback must not use
+ *        it) and runs the queued transactions back to back from it.
+ * @param hspi Instance set up with HAL_SPI_Init as a master, 3-wire
+ */
+uint16_t HAL_SPIBUS_Init(SPIBUS_HandleTypeDef *hbus, SPI_HandleTypeDef *hspi)
+{
+    assert_param_ret(hbus != NULL, HAL_ERROR);
+    assert_param_ret(hspi != NULL, HAL_ERROR);
+    assert_param_ret(IS_SPI_ALL_INSTANCE(hspi->Instance), HAL_ERROR);
+
+    hbus->hspi = hspi;
+    hbus->Head = NULL;
+    hbus->Tail = NULL;
+    hbus->Device = NULL;
+    hbus->Dummy = SPI_DUMMY_BYTE;
+    hbus->RxIfg = (hspi->Instance == SPI1) ? UCA0RXIFG : UCB0RXIFG;    // Same bit in IE2
+
+    // RX interrupt: one per byte (or per burst), it also feeds TXBUF
+    usci_callback_config_t intr_cfg;
+    intr_cfg.Module = (hspi->Instance == SPI1 ? USCI_MODULE_A : USCI_MODULE_B);
+    intr_cfg.Mode = USCIA_MODE_SPI_RX;
+    intr_cfg.Callback = HAL_SPIBUS_RXISR;
+    intr_cfg.Argin = hbus;
+    if(HAL_USCI_Intr_Alloc(&intr_cfg) != USCI_ERROR_NONE) return HAL_ERROR;
+
+    return HAL_OK;
+}
+
+/**
+ * @brief Drive the CS of a device to its inactive level (GPIO output)
+ */
+uint16_t HAL_SPIBUS_DeviceInit(const SPIBUS_DeviceTypeDef *Device)
+{
+    assert_param_ret(Device != NULL, HAL_ERROR);
+    assert_param_ret(IS_SPI_MODE(Device->Mode), HAL_ERROR);
+    assert_param_ret(IS_SPI_FIRST_BIT(Device->FirstBit), HAL_ERROR);
+    assert_param_ret(Device->Prescaler != 0, HAL_ERROR);
+
+    __SPIBUS_CS_RELEASE(Device);
+    Device->CS_Port->PDIR |= Device->CS_Pin;
+
+    return HAL_OK;
+}
+
+/**
+ * @brief Queue a transaction, and the ones linked after it through Next
+ *        (they run back to back, e.g. a command and its data with
+ *        SPIBUS_FLAG_KEEP_CS). Next is left as it is, so the same chain
+ *        can be submitted again. Does not wait: Status turns SPIBUS_DONE
+ *        before the Callback runs.
+ * @return HAL_OK, HAL_BUSY if a transaction is still pending, HAL_ERROR on bad parameters
+ */
+uint16_t HAL_SPIBUS_Submit(SPIBUS_HandleTypeDef *hbus, SPIBUS_TransactionTypeDef *xfer)
+{
+    SPIBUS_TransactionTypeDef *last;
+
+    assert_param_ret(hbus != NULL, HAL_ERROR);
+    assert_param_ret(xfer != NULL, HAL_ERROR);
+
+    // Check the whole chain before queueing any of it
+    for(last = xfer; ; last = last->Next)
+    {
+        assert_param_ret(last->Device != NULL, HAL_ERROR);
+        assert_param_ret(last->Size != 0, HAL_ERROR);
+        if(last->Status == SPIBUS_PENDING) return HAL_BUSY;
+        if(last->Next == NULL) break;
+    }
+    // Queue through Link, the chain in Next stays the caller's
+    for(last = xfer; ; last = last->Next)
+    {
+        last->Status = SPIBUS_PENDING;
+        last->Link = last->Next;
+        if(last->Next == NULL) break;
+    }
+
+    uint16_t __InterruptStatus = __get_SR_register() & 0x0008;
+    __disable_interrupt();
+    if(hbus->Head == NULL)
+    {
+        // Bus idle: start right away
+        hbus->Head = xfer;
+        hbus->Tail = last;
+        HAL_SPIBUS_Start(hbus);
+    }
+    else
+    {
+        hbus->Tail->Link = xfer;
+        hbus->Tail = last;
+    }
+    __bis_SR_register(__InterruptStatus);
+
+    return HAL_OK;
+}
+
+/**
+ * @brief 1 when no transaction is queued or on the bus
+ */
+uint8_t HAL_SPIBUS_IsIdle(SPIBUS_HandleTypeDef *hbus)
+{
+    return (hbus->Head == NULL);
+}
+
+
+/* Private reference functions -----------------------------------------------*/
+// Put the transaction at Head on the bus (interrupts masked)
+static void HAL_SPIBUS_Start(SPIBUS_HandleTypeDef *hbus)
+{
+    SPIBUS_TransactionTypeDef *xfer = hbus->Head;
+    const SPIBUS_DeviceTypeDef *dev = xfer->Device;
+    SPI_TypeDef *SPIx = hbus->hspi->Instance;
+
+    if(dev != hbus->Device)
+    {
+        // Another device: drop the CS a KEEP_CS transaction left active,
+        // then clock polarity/phase, bit order and rate (UCSWRST also
+        // clears the RX interrupt enable)
+        if(hbus->Device != NULL) __SPIBUS_CS_RELEASE(hbus->Device);
+
+        SPIx->CTL1 |= UCSWRST;
+        SPIx->CTL0 = (SPIx->CTL0 & ~(SPIBUS_CTL0_MODE_M | USCI_CTL0_MSB_M)) |
+                     (dev->Mode << USCI_CTL0_CPOL_S) | (dev->FirstBit << USCI_CTL0_MSB_S);
+        SPIx->BR0 = dev->Prescaler & 0x00FF;
+        SPIx->BR1 = (dev->Prescaler >> 8) & 0x00FF;
+        SPIx->CTL1 &= ~UCSWRST;
+
+        hbus->Device = dev;
+    }
+
+    __SPIBUS_CS_ASSERT(dev);
+
+    hbus->TxPtr = (xfer->pTxData != NULL) ? xfer->pTxData : &hbus->Dummy;
+    hbus->TxStep = (xfer->pTxData != NULL) ? 1 : 0;
+    hbus->RxPtr = xfer->pRxData;
+    hbus->Left = xfer->Size;
+    // Fast devices: an interrupt per byte would take longer than the byte
+    hbus->Burst = (dev->Prescaler <= configHAL_SPIBUS_FAST_PRESCALER) ? configHAL_SPIBUS_ISR_BURST : 1;
+
+    // First byte, the RX interrupt sends the rest
+    __HAL_SPI_CLEAR_RX_FLAG(hbus->hspi);
+    IE2 |= hbus->RxIfg;
+    SPIx->TXBUF = *hbus->TxPtr;
+    hbus->TxPtr += hbus->TxStep;
+}
+
+// Transaction at Head finished: release it and chain the next one
+static void HAL_SPIBUS_Complete(SPIBUS_HandleTypeDef *hbus)
+{
+    SPIBUS_TransactionTypeDef *xfer = hbus->Head;
+
+    if(!(xfer->Flags & SPIBUS_FLAG_KEEP_CS)) __SPIBUS_CS_RELEASE(xfer->Device);
+
+    hbus->Head = xfer->Link;
+    xfer->Link = NULL;
+    xfer->Status = SPIBUS_DONE;
+
+    // Next one first, the bus does not wait for the callback
+    if(hbus->Head != NULL) HAL_SPIBUS_Start(hbus);
+    else IE2 &= ~hbus->RxIfg;
+
+    if(xfer->Callback) __HAL_USCI_CALLBACK(xfer->Callback, xfer);
+}
+
+
+/* Interrupt service routines ------------------------------------------------*/
+static void HAL_SPIBUS_RXISR(void *argin)
+{
+    SPIBUS_HandleTypeDef *hbus = (SPIBUS_HandleTypeDef *)argin;
+    SPI_TypeDef *SPIx = hbus->hspi->Instance;
+    uint8_t burst = hbus->Burst;
+    uint8_t data;
+
+    // The vector is shared with the other USCI module
+    if(!(IFG2 & hbus->RxIfg) || !(IE2 & hbus->RxIfg)) return;
+
+    while(1)
+    {
+        data = SPIx->RXBUF;
+
+        if(hbus->RxPtr != NULL) *hbus->RxPtr++ = data;
+        if(--hbus->Left == 0)
+        {
+            HAL_SPIBUS_Complete(hbus);
+            return;
+        }
+
+        SPIx->TXBUF = *hbus->TxPtr;
+        hbus->TxPtr += hbus->TxStep;
+
+        // Fast devices: wait for the byte here, it is shorter than the
+        // interrupt exit and entry
+        if(--burst == 0) return;
+        while(!(IFG2 & hbus->RxIfg)) { }
+    }
+}
@@ -36,6 +36,8 @@
 
 static void HAL_UART_TXISR(void *argin);
 static void HAL_UART_RXISR(void *argin);
+static void HAL_UART_BufTXISR(void *argin);
+static void HAL_UART_BufRXISR(void *argin);
 
 /* Reference functions -------------------------------------------------------*/
 void HAL_UART_Init(UART_TypeDef *UARTx, UART_InitTypeDef *UART_InitStruct)
@@ -195,7 +197,7 @@ uint16_t HAL_UART_Read_IT(UART_HandleTypeDef *huart, UARTCallback_t RxCpltCallba
     __HAL_LOCK(huart);
 
     uint16_t uart_err = HAL_BUSY;
-    if(!huart->TxSize)
+    if(!huart->RxSize)
     {
         huart->RxCpltCallback = RxCpltCallback;
         huart->RxBuffer = pData;
@@ -229,6 +231,236 @@ uint16_t HAL_UART_Read_IT(UART_HandleTypeDef *huart, UARTCallback_t RxCpltCallba
     return uart_err;
 }
 
+/**
+ * @brief Set up a buffered UART on an initialised UART (HAL_UART_Init). It
+ *        takes the TX and RX interrupts of the UART.
+ * @param pTxRing,TxRingSize TX storage, power of two size
+ * @param pRxRing,RxRingSize RX storage, power of two size
+ * @return HAL_OK, HAL_ERROR if the arguments are wrong or the interrupts are taken
+ */
+uint16_t HAL_UART_InitBuf(UART_BufHandleTypeDef *hbuf, UART_TypeDef *UARTx,
+                          uint8_t *pTxRing, uint16_t TxRingSize,
+                          uint8_t *pRxRing, uint16_t RxRingSize)
+{
+    assert_param_ret(hbuf != NULL && IS_UART_ALL_INSTANCE(UARTx), HAL_ERROR);
+    assert_param_ret(pTxRing != NULL && IS_UART_RING_SIZE(TxRingSize), HAL_ERROR);
+    assert_param_ret(pRxRing != NULL && IS_UART_RING_SIZE(RxRingSize), HAL_ERROR);
+
+    hbuf->UARTx = UARTx;
+    hbuf->TxRing = pTxRing;
+    hbuf->RxRing = pRxRing;
+    hbuf->TxMask = TxRingSize - 1;
+    hbuf->RxMask = RxRingSize - 1;
+    hbuf->TxHead = 0;
+    hbuf->TxTail = 0;
+    hbuf->RxHead = 0;
+    hbuf->RxTail = 0;
+    hbuf->RxOverrun = 0;
+    hbuf->RxHook = NULL;
+    hbuf->RxHookArg = NULL;
+#if HAL_UART_USE_BLOCKING == (1)
+    hbuf->TxWaiter = NULL;
+    hbuf->RxWaiter = NULL;
+    hbuf->TxWanted = 0;
+    hbuf->RxWanted = 0;
+#endif
+
+    usci_callback_config_t intr_cfg;
+    intr_cfg.Module = USCI_MODULE_A;
+    intr_cfg.Mode = USCIA_MODE_UART_TX;
+    intr_cfg.Argin = hbuf;
+    intr_cfg.Callback = HAL_UART_BufTXISR;
+    if( HAL_USCI_Intr_Alloc(&intr_cfg) != USCI_ERROR_NONE ) return HAL_ERROR;
+
+    intr_cfg.Mode = USCIA_MODE_UART_RX;
+    intr_cfg.Callback = HAL_UART_BufRXISR;
+    if( HAL_USCI_Intr_Alloc(&intr_cfg) != USCI_ERROR_NONE )
+    {
+        intr_cfg.Mode = USCIA_MODE_UART_TX;
+        (void)HAL_USCI_Intr_Free(&intr_cfg);
+        return HAL_ERROR;
+    }
+
+    // TX is enabled by HAL_UART_WriteBuf when there is data
+    IE2 |= UCA0RXIE;
+
+    return HAL_OK;
+}
+
+/**
+ * @brief Queue up to len bytes for transmission, it never waits
+ * @param pWritten Bytes queued (can be NULL)
+ * @return HAL_OK if all the bytes were queued, HAL_BUSY if the ring was full
+ */
+uint16_t HAL_UART_WriteBuf(UART_BufHandleTypeDef *hbuf, const uint8_t *pData, uint16_t len, uint16_t *pWritten)
+{
+    uint16_t count;
+    uint16_t head;
+
+    assert_param_ret(hbuf != NULL && (pData != NULL || !len), HAL_ERROR);
+
+    count = HAL_UART_TxBufFree(hbuf);
+    if(count > len) count = len;
+
+    head = hbuf->TxHead;
+    for(uint16_t i = 0; i < count; i++)
+    {
+        hbuf->TxRing[head & hbuf->TxMask] = pData[i];
+        head++;
+    }
+
+    // Publish the bytes, then (re)start the TX interrupt. TXIFG is still set
+    // if the UART is idle, so the interrupt fires right away
+    hbuf->TxHead = head;
+    if(count) IE2 |= UCA0TXIE;
+
+    if(pWritten != NULL) *pWritten = count;
+
+    return (count == len) ? HAL_OK : HAL_BUSY;
+}
+
+/**
+ * @brief Take up to len received bytes, it never waits
+ * @param pRead Bytes copied into pData (can be NULL)
+ * @return HAL_OK if len bytes were read, HAL_BUSY if there were fewer
+ */
+uint16_t HAL_UART_ReadBuf(UART_BufHandleTypeDef *hbuf, uint8_t *pData, uint16_t len, uint16_t *pRead)
+{
+    uint16_t count;
+    uint16_t tail;
+
+    assert_param_ret(hbuf != NULL && (pData != NULL || !len), HAL_ERROR);
+
+    count = HAL_UART_RxBufCount(hbuf);
+    if(count > len) count = len;
+
+    tail = hbuf->RxTail;
+    for(uint16_t i = 0; i < count; i++)
+    {
+        pData[i] = hbuf->RxRing[tail & hbuf->RxMask];
+        tail++;
+    }
+
+    // Release the slots
+    hbuf->RxTail = tail;
+
+    if(pRead != NULL) *pRead = count;
+
+    return (count == len) ? HAL_OK : HAL_BUSY;
+}
+
+/**
+ * @brief Hand every received byte to RxHook from the RX interrupt, instead
+ *        of the RX ring (e.g. a packet decoder). NULL goes back to the ring.
+ */
+uint16_t HAL_UART_SetRxHook(UART_BufHandleTypeDef *hbuf, UARTRxHook_t RxHook, void *arg)
+{
+    assert_param_ret(hbuf != NULL, HAL_ERROR);
+
+    // The RX interrupt must not see a hook without its argument
+    uint16_t __InterruptStatus = __get_SR_register() & 0x0008;
+    __disable_interrupt();
+    hbuf->RxHookArg = arg;
+    hbuf->RxHook = RxHook;
+    __bis_SR_register(__InterruptStatus);
+
+    return HAL_OK;
+}
+
+#if HAL_UART_USE_BLOCKING == (1)
+/**
+ * @brief Queue len bytes, the calling task sleeps while the ring is full
+ * @param Timeout Ticks to wait for room in total, portMAX_DELAY waits forever
+ * @return HAL_OK if all the bytes were queued, HAL_BUSY on timeout (*pWritten tells how many)
+ */
+uint16_t HAL_UART_WriteBuf_Blocking(UART_BufHandleTypeDef *hbuf, const uint8_t *pData, uint16_t len, uint16_t *pWritten, TickType_t Timeout)
+{
+    uint16_t uart_err = HAL_OK;
+    uint16_t written = 0;
+    uint16_t count;
+    TickType_t start = xTaskGetTickCount();
+    TickType_t elapsed;
+
+    assert_param_ret(hbuf != NULL && (pData != NULL || !len), HAL_ERROR);
+
+    while(1)
+    {
+        (void)HAL_UART_WriteBuf(hbuf, &pData[written], len - written, &count);
+        written += count;
+        if(written == len) break;
+
+        elapsed = xTaskGetTickCount() - start;
+        if(Timeout != portMAX_DELAY && elapsed >= Timeout)
+        {
+            uart_err = HAL_BUSY;
+            break;
+        }
+
+        // Drop a notification given after an earlier re-check skipped the wait
+        (void)usTaskNotifyTakeIndexed(configHAL_UART_NOTIFY_INDEX, pdTRUE, 0);
+
+        // Sleep until the TX interrupt frees room for the rest (at most the whole ring)
+        hbuf->TxWanted = (len - written > hbuf->TxMask) ? hbuf->TxMask + 1 : len - written;
+        hbuf->TxWaiter = xTaskGetCurrentTaskHandle();
+        if(HAL_UART_TxBufFree(hbuf) < hbuf->TxWanted)
+        {
+            (void)usTaskNotifyTakeIndexed(configHAL_UART_NOTIFY_INDEX, pdTRUE, (Timeout == portMAX_DELAY) ? portMAX_DELAY : Timeout - elapsed);
+        }
+        hbuf->TxWaiter = NULL;
+    }
+
+    if(pWritten != NULL) *pWritten = written;
+
+    return uart_err;
+}
+
+/**
+ * @brief Read len bytes, the calling task sleeps until they arrive
+ * @param Timeout Ticks to wait in total, portMAX_DELAY waits forever
+ * @return HAL_OK if len bytes were read, HAL_BUSY on timeout (*pRead tells how many)
+ */
+uint16_t HAL_UART_ReadBuf_Blocking(UART_BufHandleTypeDef *hbuf, uint8_t *pData, uint16_t len, uint16_t *pRead, TickType_t Timeout)
+{
+    uint16_t uart_err = HAL_OK;
+    uint16_t read = 0;
+    uint16_t count;
+    TickType_t start = xTaskGetTickCount();
+    TickType_t elapsed;
+
+    assert_param_ret(hbuf != NULL && (pData != NULL || !len), HAL_ERROR);
+
+    while(1)
+    {
+        (void)HAL_UART_ReadBuf(hbuf, &pData[read], len - read, &count);
+        read += count;
+        if(read == len) break;
+
+        elapsed = xTaskGetTickCount() - start;
+        if(Timeout != portMAX_DELAY && elapsed >= Timeout)
+        {
+            uart_err = HAL_BUSY;
+            break;
+        }
+
+        // Drop a notification given after an earlier re-check skipped the wait
+        (void)usTaskNotifyTakeIndexed(configHAL_UART_NOTIFY_INDEX, pdTRUE, 0);
+
+        // Sleep until the RX interrupt has the rest (at most the whole ring)
+        hbuf->RxWanted = (len - read > hbuf->RxMask) ? hbuf->RxMask + 1 : len - read;
+        hbuf->RxWaiter = xTaskGetCurrentTaskHandle();
+        if(HAL_UART_RxBufCount(hbuf) < hbuf->RxWanted)
+        {
+            (void)usTaskNotifyTakeIndexed(configHAL_UART_NOTIFY_INDEX, pdTRUE, (Timeout == portMAX_DELAY) ? portMAX_DELAY : Timeout - elapsed);
+        }
+        hbuf->RxWaiter = NULL;
+    }
+
+    if(pRead != NULL) *pRead = read;
+
+    return uart_err;
+}
+#endif
+
 static void HAL_UART_TXISR(void *argin)
 {
     UART_HandleTypeDef *huart = (UART_HandleTypeDef *)argin;
@@ -243,7 +475,7 @@ static void HAL_UART_TXISR(void *argin)
         huart->TxSize--;
         if(!huart->TxSize)
         {
-            if(huart->TxCpltCallback) huart->TxCpltCallback(huart);
+            if(huart->TxCpltCallback) __HAL_USCI_CALLBACK(huart->TxCpltCallback, huart);
         }
     }
 }
@@ -258,11 +490,81 @@ static void HAL_UART_RXISR(void *argin)
     // Receive
     if(huart->RxSize)
     {
-         *huart->TxBuffer++ = huart->UARTx->RXBUF;
+        *huart->RxBuffer++ = huart->UARTx->RXBUF;
         huart->RxSize--;
         if(!huart->RxSize)
         {
-            if(huart->RxCpltCallback) huart->RxCpltCallback(huart);
+            if(huart->RxCpltCallback) __HAL_USCI_CALLBACK(huart->RxCpltCallback, huart);
         }
     }
 }
+
+static void HAL_UART_BufTXISR(void *argin)
+{
+    UART_BufHandleTypeDef *hbuf = (UART_BufHandleTypeDef *)argin;
+
+    // The vector is shared with USCI_B
+    if(!(IE2 & UCA0TXIE) || !(IFG2 & UCA0TXIFG)) return;
+
+    if(hbuf->TxHead != hbuf->TxTail)
+    {
+        // Writing TXBUF clears UCA0TXIFG
+        hbuf->UARTx->TXBUF = hbuf->TxRing[hbuf->TxTail & hbuf->TxMask];
+        hbuf->TxTail++;
+    }
+    else
+    {
+        // Ring empty, UCA0TXIFG is left set for the next HAL_UART_WriteBuf
+        IE2 &= ~UCA0TXIE;
+    }
+
+#if HAL_UART_USE_BLOCKING == (1)
+    if(hbuf->TxWaiter != NULL && HAL_UART_TxBufFree(hbuf) >= hbuf->TxWanted)
+    {
+        UBaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        TaskHandle_t xWaiter = hbuf->TxWaiter;
+
+        hbuf->TxWaiter = NULL;
+        vTaskNotifyGiveIndexedFromISR(xWaiter, configHAL_UART_NOTIFY_INDEX, &xHigherPriorityTaskWoken);
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    }
+#endif
+}
+
+static void HAL_UART_BufRXISR(void *argin)
+{
+    UART_BufHandleTypeDef *hbuf = (UART_BufHandleTypeDef *)argin;
+
+    // The vector is shared with USCI_B
+    if(!(IFG2 & UCA0RXIFG)) return;
+
+    // Reading RXBUF clears UCA0RXIFG
+    uint8_t data = hbuf->UARTx->RXBUF;
+    if(hbuf->RxHook != NULL)
+    {
+        hbuf->RxHook(hbuf->RxHookArg, data);
+        return;
+    }
+
+    if(HAL_UART_RxBufCount(hbuf) > hbuf->RxMask)
+    {
+        hbuf->RxOverrun++;
+    }
+    else
+    {
+        hbuf->RxRing[hbuf->RxHead & hbuf->RxMask] = data;
+        hbuf->RxHead++;
+    }
+
+#if HAL_UART_USE_BLOCKING == (1)
+    if(hbuf->RxWaiter != NULL && HAL_UART_RxBufCount(hbuf) >= hbuf->RxWanted)
+    {
+        UBaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        TaskHandle_t xWaiter = hbuf->RxWaiter;
+
+        hbuf->RxWaiter = NULL;
+        vTaskNotifyGiveIndexedFromISR(xWaiter, configHAL_UART_NOTIFY_INDEX, &xHigherPriorityTaskWoken);
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    }
+#endif
+}
@@ -29,7 +29,8 @@
 
 #define USCI_INTR_ALLOC_M    (0x80)
 #define USCI_INTR_MODE_M     (0x03)
-#define USCI_INTR_TX_M       (0x02)
+#define USCI_INTR_RX_M       (0x02)     // Mode bit 1: RX direction
+#define USCI_INTR_TYPE_M     (0x01)     // Mode bit 0: UART/I2C (1) or SPI (0)
 
 /* Exported macro ------------------------------------------------------------*/
 typedef struct
@@ -54,9 +55,9 @@ uint16_t HAL_USCI_Intr_Alloc(usci_callback_config_t *cfg)
     assert_param_ret(cfg->Mode < USCI_MODE_MAX, USCI_ERROR_INV_ID);
 
     // TX or RX
-    usci_intr_inst_t * usci_intr_inst_1 = &usci_intr_vector[cfg->Module].intr_rx;
-    usci_intr_inst_t * usci_intr_inst_2 = &usci_intr_vector[cfg->Module].intr_tx;
-    if(cfg->Mode & USCI_INTR_TX_M)
+    usci_intr_inst_t * usci_intr_inst_1 = &usci_intr_vector[cfg->Module].intr_tx;
+    usci_intr_inst_t * usci_intr_inst_2 = &usci_intr_vector[cfg->Module].intr_rx;
+    if(cfg->Mode & USCI_INTR_RX_M)
     {
         usci_intr_inst_t *usci_intr_aux =  usci_intr_inst_1;
         usci_intr_inst_1 = usci_intr_inst_2;
@@ -66,10 +67,10 @@ uint16_t HAL_USCI_Intr_Alloc(usci_callback_config_t *cfg)
     // Check if it is allocated
     assert_param_ret(!(usci_intr_inst_1->status & USCI_INTR_ALLOC_M), USCI_ERROR_BUSY);
 
-    // Check if it is other type
+    // Check if the other direction is used by another type (SPI vs UART/I2C)
     if((usci_intr_inst_2->status & USCI_INTR_ALLOC_M))
     {
-        assert_param_ret(usci_intr_inst_2->status & USCI_INTR_MODE_M == cfg->Mode, USCI_ERROR_DIFF);
+        assert_param_ret((usci_intr_inst_2->status & USCI_INTR_TYPE_M) == (cfg->Mode & USCI_INTR_TYPE_M), USCI_ERROR_DIFF);
     }
 
     // I2C interrupt always runs on TX
@@ -89,20 +90,17 @@ uint16_t HAL_USCI_Intr_Free(usci_callback_config_t *cfg)
     assert_param_ret(cfg->Mode < USCI_MODE_MAX, USCI_ERROR_INV_ID);
 
     // TX or RX
-    usci_intr_inst_t * usci_intr_inst_1 = &usci_intr_vector[cfg->Module].intr_rx;
-    usci_intr_inst_t * usci_intr_inst_2 = &usci_intr_vector[cfg->Module].intr_tx;
-    if(cfg->Mode & USCI_INTR_TX_M)
+    usci_intr_inst_t * usci_intr_inst_1 = &usci_intr_vector[cfg->Module].intr_tx;
+    if(cfg->Mode & USCI_INTR_RX_M)
     {
-        usci_intr_inst_t *usci_intr_aux =  usci_intr_inst_1;
-        usci_intr_inst_1 = usci_intr_inst_2;
-        usci_intr_inst_2 = usci_intr_aux;
+        usci_intr_inst_1 = &usci_intr_vector[cfg->Module].intr_rx;
     }
 
     // Check if it is allocated
-    assert_param_ret(!(usci_intr_inst_1->status & USCI_INTR_ALLOC_M), USCI_ERROR_BUSY);
+    assert_param_ret(usci_intr_inst_1->status & USCI_INTR_ALLOC_M, USCI_ERROR_INV_TXRX);
 
     // Check if it is same type
-    assert_param_ret(usci_intr_inst_1->status & USCI_INTR_MODE_M == cfg->Mode, USCI_ERROR_DIFF);
+    assert_param_ret((usci_intr_inst_1->status & USCI_INTR_MODE_M) == cfg->Mode, USCI_ERROR_DIFF);
 
     // Free interrupt allocation
     usci_intr_inst_1->cb = NULL;
@@ -114,9 +112,10 @@ uint16_t HAL_USCI_Intr_Free(usci_callback_config_t *cfg)
 
 
 /* Interrupt service routines ------------------------------------------------*/
-#pragma vector=USCIAB0RX_VECTOR
-__interrupt void USCIAB0RX_IRQHandle(void)
+static void HAL_USCI_RX_IRQHandler(void *arg)
 {
+    (void)arg;
+
     /* USCIA0 */
     if(usci_intr_vector[USCI_MODULE_A].intr_rx.status & USCI_INTR_ALLOC_M)
     {
@@ -136,9 +135,10 @@ __interrupt void USCIAB0RX_IRQHandle(void)
     }
 }
 
-#pragma vector=USCIAB0TX_VECTOR
-__interrupt void USCIAB0TX_IRQHandle(void)
+static void HAL_USCI_TX_IRQHandler(void *arg)
 {
+    (void)arg;
+
     /* USCIA0 */
     if(usci_intr_vector[USCI_MODULE_A].intr_tx.status & USCI_INTR_ALLOC_M)
     {
@@ -157,6 +157,18 @@ __interrupt void USCIAB0TX_IRQHandle(void)
         }
     }
 }
+
+#pragma vector=USCIAB0RX_VECTOR
+__interrupt void USCIAB0RX_IRQHandle(void)
+{
+    __HAL_USCI_RUN_ISR(HAL_USCI_RX_IRQHandler);
+}
+
+#pragma vector=USCIAB0TX_VECTOR
+__interrupt void USCIAB0TX_IRQHandle(void)
+{
+    __HAL_USCI_RUN_ISR(HAL_USCI_TX_IRQHandler);
+}
 /* Private types -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 /* Private constants ---------------------------------------------------------*/
@@ -0,0 +1,369 @@
+/*
+ * spitiming.c
+ *
+ *  Created on: 22 may 2024
+ *      Author: User123
+ *
+ * Cycle model of a USCI SPI master (SLAU144 chapter 16) driven by the
+ * blocking transfer loops of msp430_hal_spi.c. One step is one BRCLK
+ * cycle, BRCLK = SMCLK = MCLK. The CPU side costs every register access
+ * with the MSP430 instruction timings of the loop it models, interrupts are
+ * taken between instructions while GIE is set.
+ *
+ * It checks that HAL_SPI_TransmitReceive_Block never loses a byte (RX
+ * overrun) for any prescaler, with or without interrupt load, and beats
+ * the lockstep loop it replaces from UCBRx = 2 up. See README.md.
+ */
+
+/* Private includes -----------------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Private defines ---------------------------------------------------*/
+#define MCLK_HZ             (16000000UL)
+#define BLOCK_SIZE          (256)
+
+// MSP430 CPU cycles of each access, as CCS compiles the loops
+#define CYC_POLL_FLAG       (4)     // bit.b #UCxxIFG,&IFG2
+#define CYC_POLL_JUMP       (2)     // jz $-4
+#define CYC_WRITE_TX_OLD    (5)     // mov.b @R12+,&UCxTXBUF
+#define CYC_WRITE_TX        (6)     // mov.b @R12,&UCxTXBUF + add.w R10,R12 (TxStep)
+#define CYC_READ_RX         (6)     // mov.b &UCxRXBUF,0(R13)
+#define CYC_READ_RX_DISCARD (3)     // mov.b &UCxRXBUF,R14
+#define CYC_INC_PTR         (1)     // inc.w R13
+#define CYC_LOOP            (3)     // add.w #-1,R15 + jnz
+#define CYC_MASK            (4)     // mov.w SR,R11 + and + dint + nop
+#define CYC_WINDOW          (4)     // bis.w R11,SR + nop + dint + nop
+#define UNROLL              (4)     // Bytes per loop of the transmit only transfer (SPI_BLOCK_UNROLL)
+#define MASK_CYCLES         (128)   // configHAL_SPI_MASK_CYCLES
+
+#define LOOP_LOCKSTEP       (0)     // One byte in flight
+#define LOOP_BLOCK          (1)     // HAL_SPI_TransmitReceive_Block
+#define LOOP_UNMASKED       (2)     // The same pipeline with interrupts left enabled
+
+// Interrupt load: a periodic ISR (entry 6 + body + reti 5 cycles)
+#define IRQ_PERIOD          (1000)
+#define IRQ_CYCLES          (60)
+
+/* Private typedefs --------------------------------------------------*/
+typedef struct
+{
+    unsigned uBr;               // UCBRx, one UCLK period = uBr BRCLK cycles
+    int iTxFull;                // TXBUF holds a byte (UCxTXIFG = 0)
+    uint8_t ucTxBuf;
+    unsigned uLeft;             // BRCLK cycles left of the byte in the shift register, 0 = idle
+    uint8_t ucShift;
+    unsigned uIndex;            // Bytes shifted so far
+    uint8_t ucRxBuf;
+    int iRxIfg;
+    unsigned long ulOverruns;   // Bytes moved into RXBUF before the previous one was read (UCOE)
+    unsigned long ulTxLost;     // TXBUF written while full (driver bug)
+    unsigned long ulBusy;       // Cycles with the shift register active
+    uint8_t ucMosi[BLOCK_SIZE]; // What the slave saw
+} Usci_t;
+
+typedef struct
+{
+    const char *pcName;
+    int iRx;                    // 1: keep the received bytes
+    int iInterrupts;            // 1: periodic interrupt load
+    int iLoop;                  // LOOP_xxx
+} Loop_t;
+
+/* Private prototype function ----------------------------------------*/
+static void vTick(void);
+static void vCpu(unsigned uCycles);
+static int iTxIfg(void);
+static int iRxIfg(void);
+static void vWriteTx(uint8_t ucByte, unsigned uCycles);
+static uint8_t ucReadRx(unsigned uCycles);
+static uint8_t ucSlaveByte(unsigned uIndex);
+static void vLockstep(const uint8_t *pucTx, uint8_t *pucRx, unsigned uSize, int iFallback);
+static unsigned uGroup(unsigned uBr);
+static void vPipelined(const uint8_t *pucTx, uint8_t *pucRx, unsigned uSize, unsigned uBytes, int iMask);
+static void vTransmit(const uint8_t *pucTx, unsigned uSize);
+
+/* Private variables -------------------------------------------------*/
+static Usci_t xUsci;
+static unsigned long ulNow;
+static int iGie;
+static int iIrqLoad;
+static unsigned long ulNextIrq;
+static int iHang;                   // The loop waited for a flag that never comes
+
+static const Loop_t xLoops[] =
+{
+    { "lockstep TX/RX (old loop)",      1, 0, LOOP_LOCKSTEP  },
+    { "lockstep TX/RX + interrupts",    1, 1, LOOP_LOCKSTEP  },
+    { "block TX/RX",                    1, 0, LOOP_BLOCK     },
+    { "block TX/RX + interrupts",       1, 1, LOOP_BLOCK     },
+    { "unmasked pipeline + interrupts", 1, 1, LOOP_UNMASKED  },
+    { "block TX only",                  0, 0, LOOP_BLOCK     },
+    { "block TX only + interrupts",     0, 1, LOOP_BLOCK     },
+};
+
+
+/* Reference function ------------------------------------------------*/
+int main(void)
+{
+    static const unsigned uBrs[] = { 1, 2, 3, 4, 8, 16, 32 };
+    uint8_t ucTx[BLOCK_SIZE], ucRx[BLOCK_SIZE];
+    unsigned long ulLockstep[2][sizeof(uBrs)/sizeof(uBrs[0])];
+    unsigned uLoop, uBr, i;
+    int iFail = 0;
+
+    for(i = 0; i < BLOCK_SIZE; i++) ucTx[i] = (uint8_t)(i*13 + 5);
+
+    printf("%u byte block, MCLK = BRCLK = %lu MHz, ISR of %u cycles every %u cycles\n\n",
+           BLOCK_SIZE, MCLK_HZ/1000000UL, IRQ_CYCLES, IRQ_PERIOD);
+    printf("%-32s", "UCBRx");
+    for(i = 0; i < sizeof(uBrs)/sizeof(uBrs[0]); i++) printf("  %-13u", uBrs[i]);
+    printf("\n");
+
+    for(uLoop = 0; uLoop < sizeof(xLoops)/sizeof(xLoops[0]); uLoop++)
+    {
+        const Loop_t *pxLoop = &xLoops[uLoop];
+        printf("%-32s", pxLoop->pcName);
+
+        for(uBr = 0; uBr < sizeof(uBrs)/sizeof(uBrs[0]); uBr++)
+        {
+            unsigned long ulErrors = 0;
+            int iImplemented = (pxLoop->iLoop == LOOP_BLOCK);
+
+            memset(&xUsci, 0, sizeof(xUsci));
+            memset(ucRx, 0, sizeof(ucRx));
+            xUsci.uBr = uBrs[uBr];
+            ulNow = 0;
+            iGie = 1;
+            iIrqLoad = pxLoop->iInterrupts;
+            ulNextIrq = IRQ_PERIOD/3;
+            iHang = 0;
+
+            if(!pxLoop->iRx) vTransmit(ucTx, BLOCK_SIZE);
+            else if(pxLoop->iLoop == LOOP_LOCKSTEP) vLockstep(ucTx, ucRx, BLOCK_SIZE, 0);
+            else if(pxLoop->iLoop == LOOP_UNMASKED) vPipelined(ucTx, ucRx, BLOCK_SIZE, 4, 0);
+            else if(uGroup(xUsci.uBr) == 0) vLockstep(ucTx, ucRx, BLOCK_SIZE, 1);   // The HAL falls back to one byte in flight
+            else vPipelined(ucTx, ucRx, BLOCK_SIZE, uGroup(xUsci.uBr), 1);
+
+            // The slave must see the block in order, the master must get the slave bytes back
+            for(i = 0; i < BLOCK_SIZE; i++)
+            {
+                if(xUsci.ucMosi[i] != ucTx[i]) ulErrors++;
+                if(pxLoop->iRx && ucRx[i] != ucSlaveByte(i)) ulErrors++;
+            }
+            if(xUsci.uIndex != BLOCK_SIZE || xUsci.ulTxLost || (pxLoop->iRx && xUsci.ulOverruns)) ulErrors++;
+
+            if(iHang && pxLoop->iRx) printf("  %-13s", "hangs (UCOE)");
+            else printf("  %4lu kB/s %3lu%%%s", (BLOCK_SIZE*MCLK_HZ/ulNow + 500)/1000,
+                        100UL*xUsci.ulBusy/ulNow, ulErrors ? "!" : " ");
+            if(pxLoop->iRx && iHang) ulErrors++;
+
+            // The HAL loops must be exact, the unmasked one is only there to show why
+            if(iImplemented && ulErrors) iFail = 1;
+
+            // ... and, where the pipeline runs, faster than the lockstep loop
+            if(pxLoop->iLoop == LOOP_LOCKSTEP) ulLockstep[pxLoop->iInterrupts][uBr] = ulNow;
+            else if(iImplemented && pxLoop->iRx && uGroup(uBrs[uBr]) && ulNow >= ulLockstep[pxLoop->iInterrupts][uBr]) iFail = 1;
+        }
+        printf("\n");
+    }
+
+    printf("\nkB/s at %lu MHz and shift register use, ! = lost or corrupted bytes\n", MCLK_HZ/1000000UL);
+    printf("%s\n", iFail ? "FAIL" : "PASS");
+
+    return iFail;
+}
+
+
+/* Private reference functions -----------------------------------*/
+// Slave output: any pattern independent of what it receives
+static uint8_t ucSlaveByte(unsigned uIndex)
+{
+    return (uint8_t)(0xA5 ^ (uIndex*7));
+}
+
+static void vTick(void)
+{
+    if(xUsci.uLeft)
+    {
+        xUsci.ulBusy++;
+        if(--xUsci.uLeft == 0)
+        {
+            // Character complete: MOSI byte out, MISO byte into RXBUF
+            if(xUsci.uIndex < BLOCK_SIZE) xUsci.ucMosi[xUsci.uIndex] = xUsci.ucShift;
+            if(xUsci.iRxIfg) xUsci.ulOverruns++;
+            xUsci.ucRxBuf = ucSlaveByte(xUsci.uIndex++);
+            xUsci.iRxIfg = 1;
+
+            // TXBUF waiting: next character starts without a gap
+            if(xUsci.iTxFull)
+            {
+                xUsci.ucShift = xUsci.ucTxBuf;
+                xUsci.iTxFull = 0;
+                xUsci.uLeft = 8*xUsci.uBr;
+            }
+        }
+    }
+    else if(xUsci.iTxFull)
+    {
+        // Idle: TXBUF moves to the shift register on the next BRCLK
+        xUsci.ucShift = xUsci.ucTxBuf;
+        xUsci.iTxFull = 0;
+        xUsci.uLeft = 8*xUsci.uBr;
+    }
+}
+
+static void vCpu(unsigned uCycles)
+{
+    while(uCycles--)
+    {
+        vTick();
+        ulNow++;
+    }
+
+    // Interrupts are taken between instructions
+    if(iIrqLoad && iGie && ulNow >= ulNextIrq)
+    {
+        unsigned uIsr = IRQ_CYCLES;
+        ulNextIrq += IRQ_PERIOD;
+        while(uIsr--)
+        {
+            vTick();
+            ulNow++;
+        }
+    }
+}
+
+static int iTxIfg(void)
+{
+    int iFlag;
+    vCpu(CYC_POLL_FLAG);
+    iFlag = !xUsci.iTxFull;
+    vCpu(CYC_POLL_JUMP);
+    return iFlag;
+}
+
+static int iRxIfg(void)
+{
+    int iFlag, iIdle;
+    vCpu(CYC_POLL_FLAG);
+    iFlag = xUsci.iRxIfg;
+    iIdle = !xUsci.uLeft && !xUsci.iTxFull;
+    vCpu(CYC_POLL_JUMP);
+
+    // Nothing in flight and no flag: an overrun ate it, the target loop
+    // would spin forever here
+    if(!iFlag && iIdle)
+    {
+        iHang = 1;
+        iFlag = 1;
+    }
+    return iFlag;
+}
+
+static void vWriteTx(uint8_t ucByte, unsigned uCycles)
+{
+    vCpu(uCycles - 1);
+    if(xUsci.iTxFull) xUsci.ulTxLost++;
+    xUsci.ucTxBuf = ucByte;
+    xUsci.iTxFull = 1;
+    vCpu(1);
+}
+
+// Reading RXBUF clears UCxRXIFG (and UCOE)
+static uint8_t ucReadRx(unsigned uCycles)
+{
+    uint8_t ucByte;
+    vCpu(uCycles - 1);
+    ucByte = xUsci.ucRxBuf;
+    xUsci.iRxIfg = 0;
+    vCpu(1);
+    return ucByte;
+}
+
+// HAL_SPI_TransmitReceive before the block transfer, and the block transfer
+// below UCBRx = 2: one byte in flight
+static void vLockstep(const uint8_t *pucTx, uint8_t *pucRx, unsigned uSize, int iFallback)
+{
+    while(uSize--)
+    {
+        while(!iTxIfg());
+        vWriteTx(*pucTx++, iFallback ? CYC_WRITE_TX : CYC_WRITE_TX_OLD);
+        while(!iRxIfg());
+        *pucRx++ = ucReadRx(CYC_READ_RX);
+        vCpu(CYC_INC_PTR + CYC_LOOP);
+    }
+}
+
+// Bytes per masked group of HAL_SPI_TransmitReceive_Block, 0 when it keeps
+// one byte in flight
+static unsigned uGroup(unsigned uBr)
+{
+    return (uBr < 2) ? 0 : (MASK_CYCLES / 8) / uBr;
+}
+
+// HAL_SPI_TransmitReceive_Block: the next byte goes into TXBUF before the
+// current one is read, so characters follow each other without a gap.
+// Interrupts are masked within each group of uBytes bytes. Between groups
+// only one byte is in flight, so an interrupt of any length can delay the
+// transfer but not overrun RXBUF.
+static void vPipelined(const uint8_t *pucTx, uint8_t *pucRx, unsigned uSize, unsigned uBytes, int iMask)
+{
+    unsigned uStep;
+
+    if(iMask)
+    {
+        vCpu(CYC_MASK);
+        iGie = 0;
+    }
+
+    while(!iTxIfg());
+    vWriteTx(*pucTx++, CYC_WRITE_TX);
+
+    for(uStep = 0; uStep < uSize; uStep++)
+    {
+        // Group boundary: one byte in flight, TXBUF empty
+        if(iMask && uStep && (uStep % uBytes == 0))
+        {
+            iGie = 1;
+            vCpu(CYC_WINDOW/2);
+            iGie = 0;
+            vCpu(CYC_WINDOW/2);
+        }
+
+        if(uStep + 1 < uSize)
+        {
+            while(!iTxIfg());
+            vWriteTx(*pucTx++, CYC_WRITE_TX);
+        }
+        while(!iRxIfg());
+        *pucRx++ = ucReadRx(CYC_READ_RX);
+        vCpu(CYC_INC_PTR + CYC_LOOP);
+
+        if((uStep + 1) % uBytes == 0) vCpu(CYC_LOOP);
+    }
+
+    if(iMask)
+    {
+        iGie = 1;
+        vCpu(1);
+    }
+}
+
+// Transmit only: RX is ignored (overruns are harmless), no masking
+static void vTransmit(const uint8_t *pucTx, unsigned uSize)
+{
+    unsigned uLeft = uSize;
+
+    while(uLeft)
+    {
+        while(!iTxIfg());
+        vWriteTx(*pucTx++, CYC_WRITE_TX);
+        if(--uLeft % UNROLL == 0) vCpu(CYC_LOOP);
+    }
+
+    // Wait for the last character (UCBUSY) and drop RXBUF
+    while(xUsci.uLeft || xUsci.iTxFull) vCpu(CYC_POLL_FLAG + CYC_POLL_JUMP);
+    (void)ucReadRx(CYC_READ_RX_DISCARD);
+}
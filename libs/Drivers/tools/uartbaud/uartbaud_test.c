@@ -0,0 +1,195 @@
+/*
+ * uartbaud_test.c
+ *
+ *  Created on: 20 may 2024
+ *      Author: User123
+ *
+ * Host check of HAL_UART_BAUD_DEFINE (msp430_hal_uart_baud.h) against the
+ * low-frequency baud rate table of the MSP430x2xx user's guide (SLAU144,
+ * UCOS16 = 0) and against an exhaustive search over the eight modulation
+ * patterns. Build it as C (macro path) and as C++ (constexpr path), see
+ * README.md.
+ */
+
+/* Private includes -----------------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include <Drivers/msp430_hal_uart_baud.h>
+
+/* Private defines ---------------------------------------------------*/
+// BRCLK, baud rate, UCBRx, UCBRSx as listed by TI
+#define BAUD_TABLE                          \
+    X(32768UL,      1200UL,   27, 2)        \
+    X(32768UL,      2400UL,   13, 6)        \
+    X(32768UL,      4800UL,    6, 7)        \
+    X(32768UL,      9600UL,    3, 3)        \
+    X(1048576UL,    9600UL,  109, 2)        \
+    X(1048576UL,   19200UL,   54, 5)        \
+    X(1048576UL,   38400UL,   27, 2)        \
+    X(1048576UL,   56000UL,   18, 6)        \
+    X(1048576UL,  115200UL,    9, 1)        \
+    X(1048576UL,  128000UL,    8, 1)        \
+    X(1048576UL,  256000UL,    4, 1)        \
+    X(1000000UL,    9600UL,  104, 1)        \
+    X(1000000UL,   19200UL,   52, 0)        \
+    X(1000000UL,   38400UL,   26, 0)        \
+    X(1000000UL,   56000UL,   17, 7)        \
+    X(1000000UL,  115200UL,    8, 6)        \
+    X(1000000UL,  128000UL,    7, 7)        \
+    X(1000000UL,  256000UL,    3, 7)        \
+    X(4000000UL,    9600UL,  416, 6)        \
+    X(4000000UL,   19200UL,  208, 3)        \
+    X(4000000UL,   38400UL,  104, 1)        \
+    X(4000000UL,   56000UL,   71, 4)        \
+    X(4000000UL,  115200UL,   34, 6)        \
+    X(4000000UL,  128000UL,   31, 2)        \
+    X(4000000UL,  256000UL,   15, 5)        \
+    X(8000000UL,    9600UL,  833, 2)        \
+    X(8000000UL,   19200UL,  416, 6)        \
+    X(8000000UL,   38400UL,  208, 3)        \
+    X(8000000UL,   56000UL,  142, 7)        \
+    X(8000000UL,  115200UL,   69, 4)        \
+    X(8000000UL,  128000UL,   62, 4)        \
+    X(8000000UL,  256000UL,   31, 2)        \
+    X(12000000UL,   9600UL, 1250, 0)        \
+    X(12000000UL,  19200UL,  625, 0)        \
+    X(12000000UL,  38400UL,  312, 4)        \
+    X(12000000UL,  56000UL,  214, 2)        \
+    X(12000000UL, 115200UL,  104, 1)        \
+    X(12000000UL, 128000UL,   93, 6)        \
+    X(12000000UL, 256000UL,   46, 7)        \
+    X(16000000UL,   9600UL, 1666, 6)        \
+    X(16000000UL,  19200UL,  833, 2)        \
+    X(16000000UL,  38400UL,  416, 6)        \
+    X(16000000UL,  56000UL,  285, 6)        \
+    X(16000000UL, 115200UL,  138, 7)        \
+    X(16000000UL, 128000UL,  125, 0)        \
+    X(16000000UL, 256000UL,   62, 4)
+
+/* Private typedefs --------------------------------------------------*/
+typedef struct
+{
+    unsigned long ulBrclk;
+    unsigned long ulBaud;
+    unsigned uTiPrescaler;
+    unsigned uTiBrs;
+    unsigned uPrescaler;        // From HAL_UART_BAUD_DEFINE
+    unsigned uBrs;
+} BaudCase_t;
+
+/* Private prototype function ----------------------------------------*/
+static unsigned long long ullWorstError(unsigned long ulBrclk, unsigned long ulBaud, unsigned uBrs);
+
+/* Private variables -------------------------------------------------*/
+// One HAL_UART_BAUD_DEFINE per table entry, evaluated by the compiler
+#define X(BRCLK, BAUD, BR, BRS)     HAL_UART_BAUD_DEFINE(B_##BRCLK##_##BAUD, BRCLK, BAUD);
+BAUD_TABLE
+#undef X
+
+static const BaudCase_t xCases[] =
+{
+#define X(BRCLK, BAUD, BR, BRS)     { BRCLK, BAUD, BR, BRS, HAL_UART_BAUD_PRESCALER(B_##BRCLK##_##BAUD), (B_##BRCLK##_##BAUD##_MCTL) >> UART_MCTL_BRS_S },
+BAUD_TABLE
+#undef X
+};
+
+
+/* Reference function ------------------------------------------------*/
+int main(void)
+{
+    unsigned uCase, uBrs;
+    unsigned uMatch = 0, uTie = 0, uFail = 0;
+
+#ifdef __cplusplus
+    printf("HAL_UART_BAUD_DEFINE, C++ constexpr path\n");
+#else
+    printf("HAL_UART_BAUD_DEFINE, C macro path\n");
+#endif
+    printf("   BRCLK     baud  | TI UCBRx/S  | HAL UCBRx/S | worst TX error %%  | \n");
+
+    for(uCase = 0; uCase < sizeof(xCases)/sizeof(xCases[0]); uCase++)
+    {
+        const BaudCase_t *pxCase = &xCases[uCase];
+        unsigned long long ullBest = ~0ULL;
+        unsigned long long ullHal = ullWorstError(pxCase->ulBrclk, pxCase->ulBaud, pxCase->uBrs);
+        unsigned long long ullTi = ullWorstError(pxCase->ulBrclk, pxCase->ulBaud, pxCase->uTiBrs);
+        const char *pcVerdict;
+
+        for(uBrs = 0; uBrs < 8; uBrs++)
+        {
+            unsigned long long ullError = ullWorstError(pxCase->ulBrclk, pxCase->ulBaud, uBrs);
+            if(ullError < ullBest) ullBest = ullError;
+        }
+
+        // TI lists either pattern of a tie, both are equally good
+        if(pxCase->uPrescaler != pxCase->uTiPrescaler) pcVerdict = "FAIL", uFail++;
+        else if(pxCase->uBrs == pxCase->uTiBrs) pcVerdict = "ok", uMatch++;
+        else if(ullHal == ullTi) pcVerdict = "tie", uTie++;
+        else if(ullHal <= ullBest + (unsigned long long)pxCase->ulBrclk*2/1000) pcVerdict = "near tie", uTie++;
+        else pcVerdict = "FAIL", uFail++;
+
+        printf("%8lu %8lu  | %5u / %u   | %5u / %u   | %6.2f (TI %6.2f) | %s\n",
+               pxCase->ulBrclk, pxCase->ulBaud, pxCase->uTiPrescaler, pxCase->uTiBrs,
+               pxCase->uPrescaler, pxCase->uBrs,
+               100.0*(double)ullHal/pxCase->ulBrclk, 100.0*(double)ullTi/pxCase->ulBrclk, pcVerdict);
+    }
+
+    printf("%u match, %u ties, %u failed\n", uMatch, uTie, uFail);
+
+#ifdef __cplusplus
+    // The constexpr search also runs on the host: sweep it against the
+    // exhaustive search
+    {
+        unsigned long ulChecked = 0, ulWorse = 0;
+        const unsigned long ulClocks[] = { 32768UL, 1000000UL, 1048576UL, 4000000UL, 8000000UL, 12000000UL, 16000000UL };
+        for(unsigned c = 0; c < sizeof(ulClocks)/sizeof(ulClocks[0]); c++)
+        {
+            for(unsigned long ulBaud = 300; ulClocks[c]/ulBaud >= 3; ulBaud += 7)
+            {
+                UART_BaudTypeDef xBaud = HAL_UART_BaudCalc(ulClocks[c], ulBaud);
+                unsigned long long ullBest = ~0ULL;
+                if(ulClocks[c]/ulBaud > 0xFFFF) continue;
+                for(uBrs = 0; uBrs < 8; uBrs++)
+                {
+                    unsigned long long ullError = ullWorstError(ulClocks[c], ulBaud, uBrs);
+                    if(ullError < ullBest) ullBest = ullError;
+                }
+                if(ullWorstError(ulClocks[c], ulBaud, xBaud.Modulation >> UART_MCTL_BRS_S) != ullBest) ulWorse++;
+                ulChecked++;
+            }
+        }
+        printf("sweep: %lu pairs, %lu not optimal\n", ulChecked, ulWorse);
+        if(ulWorse) uFail++;
+    }
+#endif
+
+    return uFail ? 1 : 0;
+}
+
+
+/* Private reference functions -----------------------------------*/
+// Plain reimplementation of the error, independent of the header
+static unsigned long long ullWorstError(unsigned long ulBrclk, unsigned long ulBaud, unsigned uBrs)
+{
+    static const unsigned char ucPattern[8][8] =
+    {
+        { 0, 0, 0, 0, 0, 0, 0, 0 }, { 0, 1, 0, 0, 0, 0, 0, 0 },
+        { 0, 1, 0, 0, 0, 1, 0, 0 }, { 0, 1, 0, 1, 0, 1, 0, 0 },
+        { 0, 1, 0, 1, 0, 1, 0, 1 }, { 0, 1, 1, 1, 0, 1, 0, 1 },
+        { 0, 1, 1, 1, 0, 1, 1, 1 }, { 0, 1, 1, 1, 1, 1, 1, 1 }
+    };
+    unsigned long long ullWorst = 0;
+    long long llTime = 0;
+    unsigned uBit;
+
+    for(uBit = 0; uBit < UART_BAUD_FRAME_BITS; uBit++)
+    {
+        long long llError;
+        llTime += (long long)(ulBrclk/ulBaud) + ucPattern[uBrs][uBit & 7];
+        llError = llTime*(long long)ulBaud - (long long)(uBit + 1)*(long long)ulBrclk;
+        if(llError < 0) llError = -llError;
+        if((unsigned long long)llError > ullWorst) ullWorst = (unsigned long long)llError;
+    }
+
+    return ullWorst;
+}
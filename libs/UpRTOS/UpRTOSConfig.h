@@ -18,15 +18,45 @@
 #define configCPU_CLOCK_HZ          (16000000UL)
 #define configTICK_RATE_HZ          (1000UL)
 #define configUSE_16_BIT_TICKS      (0)
+#define configUSE_EDF_SCHEDULING    (0)     // (fixed priority, earliest deadline first within a priority)
 // Mutex
 #define configUSE_MUTEXS            (1)
 // Notifications
 #define configUSE_NOTIFICATIONS     (1)
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   (1)
+// Deferred calls (interrupt work queue, requires notifications)
+#define configUSE_DEFERRED_CALLS    (0)
+#define configDEFER_QUEUE_LENGTH    (4)     // (power of two)
+#define configDEFER_TASK_PRIORITY   (configMAX_PRIORITIES)
+#define configDEFER_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE + 16)
+// Basic tasks (run-to-completion handlers sharing one stack, requires notifications)
+#define configUSE_BASIC_TASKS       (0)
+#define configBASIC_STACK_SIZE      (configMINIMAL_STACK_SIZE + 24)
+// Interrupt-masked time tracing (critical sections and HAL locks)
+#define configUSE_CRITICAL_TRACE        (0)
+#define configTRACE_MAX_SITES           (6)
+#define configTRACE_HISTOGRAM_BUCKETS   (8)
+#define configTRACE_BUCKET_SHIFT        (6)     // (bucket 0 < 64 timer counts = 4 us at 16 MHz)
+// Tokenized logging (format strings stay on the host, see UpLogMessages.def and tools/uplog)
+#define configUSE_TOKEN_LOG         (0)
+#define configLOG_BUFFER_SIZE       (64)    // (in bytes, power of two)
+#define configLOG_MAX_ARGS          (4)     // (16-bit arguments per record)
+#define configLOG_DRAIN_PERIOD      (pdMS_TO_TICKS(20))
+#define configLOG_TASK_PRIORITY     (configIDLE_PRIORITY + 1)
+#define configLOG_TASK_STACK_SIZE   (configMINIMAL_STACK_SIZE + 24)
 
 // Stack
 #define configTOTAL_HEAP_SIZE       (400)   // (in bytes)(max bytes = 512 - C_STACK(Project Properties)
 #define configMINIMAL_STACK_SIZE    (40)    // (in bytes)(32 bytes for cpu registers)
 #define configSTACK_ENHANCED        (0)
+#define configUSE_ISR_STACK         (0)     // (interrupt bodies run on a shared stack, see vPortRunOnISRStack)
+#define configISR_STACK_SIZE        (64)    // (in bytes)
+#define configUSE_HEAP_FREE         (1)     // (coalescing allocator, required by vPortFree)
+// Task deletion (requires configUSE_HEAP_FREE)
+#define configUSE_TASK_DELETE       (1)
+// Introspection (uxTaskGetSystemState)
+#define configUSE_TRACE_FACILITY        (0)     // (stacks are filled on creation to get their high-water mark)
+#define configGENERATE_RUN_TIME_STATS   (0)     // (run time per task, see portGET_RUN_TIME_COUNTER_VALUE)
 
 
 
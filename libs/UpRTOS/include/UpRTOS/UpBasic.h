@@ -0,0 +1,74 @@
+/**
+  ******************************************************************************
+  * @file       UpBasic.h
+  * @author     Fernando Hermosillo Reynoso
+  * @brief      This file contains the prototype functions for the UpRTOS
+  *             basic (run-to-completion) task module
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 Universidad Panamericana.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef UPRTOS_UPBASIC_H_
+#define UPRTOS_UPBASIC_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <UpRTOSConfig.h>
+#include <UpRTOS/UpTypes.h>
+#include <UpRTOS/UpPortable.h>
+
+/* Exported types ------------------------------------------------------------*/
+typedef void (* BasicFunction_t)( void *pvParameter );
+
+/**
+ * @brief Basic task, a handler that runs to completion on the dispatcher
+ *        stack each time it is activated. It must not block. Allocated by
+ *        the application (it is never freed).
+ */
+typedef struct BasicTask
+{
+    BasicFunction_t pxFunction;         /**< Handler */
+    void *pvParameter;                  /**< Argument passed to pxFunction */
+    UBaseType_t uxPriority;             /**< Same scale as the UpRTOS tasks */
+    volatile uint8_t ucActivations;     /**< Pending activations */
+    struct BasicTask *pxNext;           /**< Basic task list, descending priority */
+} BasicTask_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+UBaseType_t xBasicCreateDispatcher(void);
+UBaseType_t xBasicTaskCreate(   BasicTask_t *pxBasicTask,
+                                BasicFunction_t pxFunction,
+                                void *pvParameter,
+                                UBaseType_t uxPriority );
+UBaseType_t xBasicTaskActivate(BasicTask_t *pxBasicTask);
+UBaseType_t xBasicTaskActivateFromISR(  BasicTask_t *pxBasicTask,
+                                        UBaseType_t *pxHigherPriorityTaskWoken );
+
+/* Private types -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private constants ---------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPRTOS_UPBASIC_H_ */
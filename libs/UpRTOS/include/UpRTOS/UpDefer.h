@@ -0,0 +1,57 @@
+/**
+  ******************************************************************************
+  * @file       UpDefer.h
+  * @author     Fernando Hermosillo Reynoso
+  * @brief      This file contains the prototype functions for the UpRTOS
+  *             deferred call (interrupt work queue) module
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 Universidad Panamericana.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef UPRTOS_UPDEFER_H_
+#define UPRTOS_UPDEFER_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <UpRTOSConfig.h>
+#include <UpRTOS/UpTypes.h>
+#include <UpRTOS/UpPortable.h>
+
+/* Exported types ------------------------------------------------------------*/
+typedef void (* DeferredFunction_t)( void *pvParameter );
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+UBaseType_t xDeferCreateDaemon(void);
+UBaseType_t xDeferFunctionCall(DeferredFunction_t pxFunction, void *pvParameter);
+UBaseType_t xDeferFunctionCallFromISR(  DeferredFunction_t pxFunction,
+                                        void *pvParameter,
+                                        UBaseType_t *pxHigherPriorityTaskWoken );
+
+/* Private types -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private constants ---------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPRTOS_UPDEFER_H_ */
@@ -0,0 +1,91 @@
+/**
+  ******************************************************************************
+  * @file       UpLog.h
+  * @author     Fernando Hermosillo Reynoso
+  * @brief      This file contains the prototype functions for the UpRTOS
+  *             tokenized log module
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 Universidad Panamericana.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef UPRTOS_UPLOG_H_
+#define UPRTOS_UPLOG_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <UpRTOSConfig.h>
+#include <UpRTOS/UpTypes.h>
+#include <UpRTOS/UpPortable.h>
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief Sink of the log daemon, it gets one whole record per call
+ *        (a UART write, a HAL_FRAME_Send, ...)
+ */
+typedef void (* LogOutput_t)( const uint8_t *pucRecord, UBaseType_t uxLength );
+
+#if configUSE_TOKEN_LOG == (1)
+typedef enum
+{
+    LOG_ID_DROPPED = 0,     /**< Sent by the daemon: records lost because the buffer was full */
+#define LOG_MESSAGE(xId, pcFormat)  xId,
+#include <UpLogMessages.def>
+#undef LOG_MESSAGE
+    LOG_ID_COUNT
+} LogId_t;
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+// Record: id, number of arguments, tick count (16 LSBs, little endian),
+// then the arguments as 16-bit little endian words
+#define logRECORD_HEADER_SIZE   (4)
+
+/* Exported macro ------------------------------------------------------------*/
+/**
+ * @brief logWRITE(LOG_xxx, arg1, ...) stores the message id and its raw
+ *        arguments, the text is only built by the host. Safe from tasks and
+ *        interrupts. Arguments are 16-bit, use logU32 for 32-bit values.
+ */
+#if configUSE_TOKEN_LOG == (1)
+#define logWRITE(...)       vLogWrite(logNARGS(__VA_ARGS__), __VA_ARGS__)
+#else
+#define logWRITE(...)
+#endif
+#define logU32(ulValue)     (UBaseType_t)(ulValue), (UBaseType_t)((uint32_t)(ulValue) >> 16)
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+#if configUSE_TOKEN_LOG == (1)
+UBaseType_t xLogCreateDaemon(LogOutput_t pxOutput);
+void vLogWrite(UBaseType_t uxArgs, UBaseType_t uxId, ...);
+#endif
+
+/* Private types -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private constants ---------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+// Number of arguments after the message id (up to 8)
+#define logNARGS(...)       logNARGS_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, ~)
+#define logNARGS_(xId, a1, a2, a3, a4, a5, a6, a7, a8, N, ...)  N
+
+/* Private functions ---------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPRTOS_UPLOG_H_ */
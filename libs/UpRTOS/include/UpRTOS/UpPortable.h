@@ -29,6 +29,7 @@
 #include <msp430.h>
 #include <UpRTOSConfig.h>
 #include <UpRTOS/UpTypes.h>
+#include <UpRTOS/UpTrace.h>
 
 /* Exported types ------------------------------------------------------------*/
 typedef uint16_t StackType_t;
@@ -45,6 +46,8 @@ typedef int16_t BaseType_t;
 /* Exported constants --------------------------------------------------------*/
 #define portINT_ENABLED_MASK    (0x0008)
 #define portMCLK_FREQUENCY_HZ   (16000000UL)
+#define portINITIAL_CRITICAL_NESTING    (10)    // Kernel calls leave GIE cleared until the first task runs
+#define portRUN_TIME_COUNTER_SHIFT      (4)     // Run time unit = 16 Systick timer clocks (1 us at 16 MHz)
 
 /* Exported macro ------------------------------------------------------------*/
 #define portENABLE_INTERRUPTS()     __enable_interrupt();\
@@ -54,18 +57,40 @@ typedef int16_t BaseType_t;
 
 #define portENTER_CRITICAL()    {\
                                     UBaseType_t xInterruptStatus__ = __get_SR_register() & 0x0008;\
-                                    __disable_interrupt();
-#define portEXIT_CRITICAL()         __bis_SR_register(xInterruptStatus__);\
+                                    __disable_interrupt();\
+                                    if(xInterruptStatus__) { traceMASK_BEGIN(); }
+#define portEXIT_CRITICAL()         if(xInterruptStatus__) { traceMASK_END(); }\
+                                    __bis_SR_register(xInterruptStatus__);\
                                 }
 
+#define portYIELD_FROM_ISR(xSwitchRequired)     if( (xSwitchRequired) != pdFALSE ) vPortYieldFromISR()
+
+#if configGENERATE_RUN_TIME_STATS == (1)
+#define portGET_RUN_TIME_COUNTER_VALUE()        ulPortGetRunTimeCounterValue()
+#endif
+
 #define portSAVE_CPU_STATUS()       asm(" push  SR\n")
 #define portRESTORE_CPU_STATUS()    asm(" pop  SR\n")
 
 /* Exported variables --------------------------------------------------------*/
+extern volatile UBaseType_t uxCriticalNesting;  // Saved in the context of every task
 
 /* Exported functions --------------------------------------------------------*/
 UBaseType_t xPortSetuptTimerInterrupt(void);    //// SysTick (TA1-CCR0)
 StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters);
+void vPortYieldFromISR(void);
+void vPortTickHandler(void);
+UBaseType_t xPortTickPending(void);
+#if configGENERATE_RUN_TIME_STATS == (1)
+uint32_t ulPortGetRunTimeCounterValue(void);
+#endif
+
+// UpPortable.asm
+void vPortStartFirstTask(void);
+void vPortYield(void);
+#if configUSE_ISR_STACK == (1)
+void vPortRunOnISRStack(TaskFunction_t pxHandler, void *pvParameter);
+#endif
 //void vPortPreemptiveTickISR(void);
 //void vPortCooperativeTickISR(void);
 //__bic_SR_register_on_exit(SCG1 | SCG0 | OSCOFF | CPUOFF);
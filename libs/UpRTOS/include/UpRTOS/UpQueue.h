@@ -41,6 +41,8 @@ typedef void * QueueHandle_t;
 QueueHandle_t xQueueCreate(uint8_t ucNumItems, uint8_t ucSizePerItem);
 UBaseType_t xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait);
 UBaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait);
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue);
+UBaseType_t uxQueueSpacesAvailable(const QueueHandle_t xQueue);
 
 /* Private types -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
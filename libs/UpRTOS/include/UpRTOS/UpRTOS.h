@@ -29,6 +29,10 @@
 #include <UpRTOS/UpTask.h>
 #include <UpRTOS/UpQueue.h>
 #include <UpRTOS/UpMutex.h>
+#include <UpRTOS/UpDefer.h>
+#include <UpRTOS/UpBasic.h>
+#include <UpRTOS/UpTrace.h>
+#include <UpRTOS/UpLog.h>
 
 /* Exported constants --------------------------------------------------------*/
 /* Exported macro ------------------------------------------------------------*/
@@ -38,9 +38,36 @@ typedef enum {
     eNoAction,
     eSetBits,
     eIncrement,
-    eSetValueWithOverwrite
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite
 } eNotifyAction;
 
+typedef enum {
+    TASK_RUNNING = 0,
+    TASK_READY,
+    TASK_SUSPENDED,
+    TASK_BLOCKED,
+    TASK_DELETED
+} eTaskState;
+
+#if configUSE_TRACE_FACILITY == (1)
+/**
+ * @brief Snapshot of one task, filled by uxTaskGetSystemState
+ */
+typedef struct
+{
+    TaskHandle_t xHandle;               /**< Task handle */
+    UBaseType_t uxId;                   /**< Task ID (configMAX_TASKS for the idle task) */
+    UBaseType_t uxPriority;             /**< Current priority */
+    eTaskState eCurrentState;           /**< State at the time of the snapshot */
+    TickType_t xTimeToWake;             /**< Wake time, only meaningful in TASK_BLOCKED */
+    uint16_t usStackHighWaterMark;      /**< Minimum free stack ever, in bytes */
+#if configGENERATE_RUN_TIME_STATS == (1)
+    uint32_t ulRunTimeCounter;          /**< Time spent running, in portGET_RUN_TIME_COUNTER_VALUE units */
+#endif
+} TaskStatus_t;
+#endif
+
 /* Exported constants --------------------------------------------------------*/
 #define tskMAX_DELAY_FLAG   (0x01)
 #define tskTIMEOUT_FLAG     (0x02)
@@ -58,6 +85,29 @@ typedef enum {
 /* Exported macro ------------------------------------------------------------*/
 #define vTaskYield()    vPortTaskYield(yldNORMAL_YIELD)
 
+// Nestable critical sections for task context only. Entering always masks
+// the interrupts, only the outermost exit enables them: before the scheduler
+// starts (portINITIAL_CRITICAL_NESTING) they stay masked until the first
+// task runs. Interrupts use portENTER_CRITICAL/portEXIT_CRITICAL.
+#define taskENTER_CRITICAL()    do {\
+                                    portDISABLE_INTERRUPTS();\
+                                    if( uxCriticalNesting == 0 ) { traceMASK_BEGIN(); }\
+                                    uxCriticalNesting++;\
+                                } while(0)
+#define taskEXIT_CRITICAL()     do {\
+                                    if( --uxCriticalNesting == 0 ) { traceMASK_END(); portENABLE_INTERRUPTS(); }\
+                                } while(0)
+
+// Notifications (index 0 of the notification array)
+#define xTaskNotifyWait(usBitsToClear,pusNotificationValue,xTicksToWait)    xTaskNotifyWaitIndexed(0,(usBitsToClear),(pusNotificationValue),(xTicksToWait))
+#define xTaskNotify(xTaskToNotify,usValue,eAction)                          xTaskNotifyIndexed((xTaskToNotify),0,(usValue),(eAction))
+#define vTaskNotifyFromISR(xTaskToNotify,usValue,eAction,pxWoken)           vTaskNotifyIndexedFromISR((xTaskToNotify),0,(usValue),(eAction),(pxWoken))
+#define xTaskNotifyGive(xTaskToNotify)                                      xTaskNotifyIndexed((xTaskToNotify),0,0,eIncrement)
+#define xTaskNotifyGiveIndexed(xTaskToNotify,uxIndex)                       xTaskNotifyIndexed((xTaskToNotify),(uxIndex),0,eIncrement)
+#define vTaskNotifyGiveFromISR(xTaskToNotify,pxWoken)                       vTaskNotifyIndexedFromISR((xTaskToNotify),0,0,eIncrement,(pxWoken))
+#define vTaskNotifyGiveIndexedFromISR(xTaskToNotify,uxIndex,pxWoken)        vTaskNotifyIndexedFromISR((xTaskToNotify),(uxIndex),0,eIncrement,(pxWoken))
+#define usTaskNotifyTake(xClearCountOnExit,xTicksToWait)                    usTaskNotifyTakeIndexed(0,(xClearCountOnExit),(xTicksToWait))
+
 /* Exported variables --------------------------------------------------------*/
 
 /* Exported functions --------------------------------------------------------*/
@@ -70,34 +120,61 @@ UBaseType_t xTaskCreate(TaskFunction_t xTaskFunc,
 TaskHandle_t xTaskGetCurrentTaskHandle(void);
 TaskHandle_t xTaskGetHandle(UBaseType_t uxTaskID );
 void vTaskDelay(const TickType_t xTicksToDelay);
+void vTaskDelayUntil(TickType_t * const pxPreviousWakeTime, const TickType_t xTimeIncrement);
+#if configUSE_EDF_SCHEDULING == (1)
+UBaseType_t xTaskSetTimingConstraints(TaskHandle_t xTask, const TickType_t xPeriod, const TickType_t xRelativeDeadline);
+void vTaskWaitForNextPeriod(void);
+#endif
+UBaseType_t uxTaskPriorityGet(const TaskHandle_t xTask);
+void vTaskPrioritySet(TaskHandle_t xTask, UBaseType_t uxNewPriority);
 void vTaskSuspend(TaskHandle_t xTaskToSuspend);
 void vTaskResume(TaskHandle_t xTaskToResume);
+#if configUSE_TASK_DELETE == (1)
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+#endif
 
 // Must run with privilege
 BaseType_t xTaskRemoveFromEventList(List_t * const pxEventList );
 BaseType_t xTaskPlaceOnEventList(List_t * const pxEventList, const TickType_t xTicksToWait);
 void vTaskYieldFromEventList(List_t * const xList);
 
+// Scheduler lock, interrupts stay enabled. A task must not block while it holds it
+void vTaskSuspendAll(void);
+UBaseType_t xTaskResumeAll(void);
+
 TickType_t xTaskGetTickCount(void);
 UBaseType_t xTaskCheckTimeout(void);
 
+#if configUSE_TRACE_FACILITY == (1)
+// Introspection
+UBaseType_t uxTaskGetNumberOfTasks(void);
+UBaseType_t uxTaskGetSystemState(   TaskStatus_t * const pxTaskStatusArray,
+                                    const UBaseType_t uxArraySize,
+                                    uint32_t * const pulTotalRunTime );
+#endif
+
 // Notifications
-UBaseType_t xTaskNotifyWait(    uint16_t usBitsToClear,
-                                uint16_t *pusNotificationValue,
-                                TickType_t xTicksToWait);
-UBaseType_t xTaskNotify( TaskHandle_t xTaskToNotify,
-                       uint16_t usValue,
-                       eNotifyAction eAction);
-void vTaskNotifyFromISR(    TaskHandle_t xTaskToNotify,
-                            uint16_t usValue,
-                            eNotifyAction eAction,
-                            UBaseType_t *pxHigherPriorityTaskWoken );
+UBaseType_t xTaskNotifyWaitIndexed( UBaseType_t uxIndexToWaitOn,
+                                    uint16_t usBitsToClear,
+                                    uint16_t *pusNotificationValue,
+                                    TickType_t xTicksToWait);
+UBaseType_t xTaskNotifyIndexed( TaskHandle_t xTaskToNotify,
+                                UBaseType_t uxIndexToNotify,
+                                uint16_t usValue,
+                                eNotifyAction eAction);
+void vTaskNotifyIndexedFromISR( TaskHandle_t xTaskToNotify,
+                                UBaseType_t uxIndexToNotify,
+                                uint16_t usValue,
+                                eNotifyAction eAction,
+                                UBaseType_t *pxHigherPriorityTaskWoken );
+uint16_t usTaskNotifyTakeIndexed(   UBaseType_t uxIndexToWaitOn,
+                                    UBaseType_t xClearCountOnExit,
+                                    TickType_t xTicksToWait);
 
 // Port
-// TODO: Move to UpPortable.asm
 void vPortTaskYield(UBaseType_t xYieldFlags);
-inline void vPortSaveContextFromISR(void);
-inline void vPortRestoreContextFromISR(void);
+void vTaskSwitchContext(void);
+void vTaskIncrementTick(void);
 
 /* Private types -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
@@ -0,0 +1,109 @@
+/**
+  ******************************************************************************
+  * @file       UpTrace.h
+  * @author     Fernando Hermosillo Reynoso
+  * @brief      This file contains the prototype functions for the UpRTOS
+  *             interrupt-masked time tracing
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 Universidad Panamericana.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef UPRTOS_UPTRACE_H_
+#define UPRTOS_UPTRACE_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <UpRTOSConfig.h>
+#include <stdint.h>
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief Interrupt-masked durations of one call site, in Systick timer counts
+ *        (TA1 clock, configCPU_CLOCK_HZ)
+ */
+typedef struct
+{
+    const char *pcFile;     /**< __FILE__ of the section that masked the interrupts */
+    uint16_t usLine;        /**< __LINE__ of the section that masked the interrupts */
+    uint16_t usMax;         /**< Longest masked time */
+    uint8_t ucHistogram[configTRACE_HISTOGRAM_BUCKETS]; /**< Bucket 0 < 2^configTRACE_BUCKET_SHIFT counts, the limit doubles per bucket (saturating) */
+} TraceSite_t;
+
+/**
+ * @brief Masked section open across a kernel yield, kept on the stack of the
+ *        yielding task
+ */
+typedef struct
+{
+    const char *pcFile;
+    uint16_t usLine;
+} TraceMark_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+#define traceCOUNTS_TO_US(usCounts)     ( (uint16_t)( (usCounts) / (uint16_t)(configCPU_CLOCK_HZ / 1000000UL) ) )
+
+// Called right after the interrupts are masked and right before they are
+// enabled again, only by the outermost section
+#if configUSE_CRITICAL_TRACE == (1)
+#define traceMASK_BEGIN()   vTraceMaskBegin(__FILE__, __LINE__)
+#define traceMASK_END()     vTraceMaskEnd()
+#else
+#define traceMASK_BEGIN()
+#define traceMASK_END()
+#endif
+
+// Around a kernel yield inside a masked section: the section is measured up
+// to the switch and again from the return, other tasks mask in between.
+// vTaskSwitchContext drops a section still open (traceMASK_SWITCH).
+#if configUSE_CRITICAL_TRACE == (1)
+#define traceMASK_YIELD_BEGIN() {\
+                                    TraceMark_t xTraceMark__;\
+                                    vTraceMaskPause(&xTraceMark__);
+#define traceMASK_YIELD_END()       vTraceMaskResume(&xTraceMark__);\
+                                }
+#define traceMASK_SWITCH()      vTraceMaskSwitch()
+#else
+#define traceMASK_YIELD_BEGIN()
+#define traceMASK_YIELD_END()
+#define traceMASK_SWITCH()
+#endif
+
+/* Exported variables --------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+#if configUSE_CRITICAL_TRACE == (1)
+void vTraceMaskBegin(const char *pcFile, uint16_t usLine);
+void vTraceMaskEnd(void);
+void vTraceMaskPause(TraceMark_t *pxMark);
+void vTraceMaskResume(const TraceMark_t *pxMark);
+void vTraceMaskSwitch(void);
+uint16_t uxTraceGetSites(const TraceSite_t **ppxSites);
+uint16_t uxTraceGetDropped(void);
+void vTraceReset(void);
+#endif
+
+/* Private types -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private constants ---------------------------------------------------------*/
+/* Private macros ------------------------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPRTOS_UPTRACE_H_ */
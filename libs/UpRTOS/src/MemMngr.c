@@ -8,18 +8,203 @@
 
 /* Public includes ------------------------------------*/
 #include <UpRTOS/MemMngr.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /* Defines --------------------------------------------*/
+#if configUSE_HEAP_FREE == (1)
+#define heapSTRUCT_SIZE             ( sizeof(BlockLink_t) )
+#define heapMINIMUM_BLOCK_SIZE      ( heapSTRUCT_SIZE << 1 )
+#define heapBLOCK_ALLOCATED_BITMASK ( 0x8000U )
+#define heapBYTE_ALIGNMENT_MASK     ( sizeof(UBaseType_t) - 1 )
+#endif
 
 /* Macros ---------------------------------------------*/
 
 /* Typedefs -------------------------------------------*/
+#if configUSE_HEAP_FREE == (1)
+typedef struct BlockLink
+{
+    struct BlockLink *pxNextFreeBlock;  /**< The next free block in the list (sorted by address) */
+    uint16_t xBlockSize;                /**< The size of the block, including this header */
+} BlockLink_t;
+#endif
+
+/* Private prototype function ------------------------*/
+#if configUSE_HEAP_FREE == (1)
+static void vHeapInit(void);
+static void vHeapInsertBlockIntoFreeList(BlockLink_t *pxBlockToInsert);
+#endif
 
 /* Private Variables ----------------------------------*/
 uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#if configUSE_HEAP_FREE == (1)
+static BlockLink_t xStart;
+static BlockLink_t *pxEnd = NULL;
+static uint16_t xFreeBytesRemaining = ( uint16_t ) 0U;
+#else
 uint16_t xNextFreeByte = ( uint16_t ) 0U;
+#endif
 
 /* Reference function ---------------------------------*/
+#if configUSE_HEAP_FREE == (1)
+void *pvPortMalloc(uint16_t xWantedSize)
+{
+    void * pvReturn = NULL;
+    BlockLink_t *pxBlock, *pxPreviousBlock, *pxNewBlockLink;
+
+    /* Enter a critical section */
+    portENTER_CRITICAL();
+
+    /* The first call initialises the free list */
+    if( pxEnd == NULL ) vHeapInit();
+
+    // Add the block header and keep the CPU word alignment
+    if( ( xWantedSize > 0 ) && ( ( xWantedSize & heapBLOCK_ALLOCATED_BITMASK ) == 0 ) )
+    {
+        xWantedSize += heapSTRUCT_SIZE;
+        if( xWantedSize & heapBYTE_ALIGNMENT_MASK ) xWantedSize += sizeof(UBaseType_t) - ( xWantedSize & heapBYTE_ALIGNMENT_MASK );
+    }
+    else
+    {
+        xWantedSize = 0;
+    }
+
+    if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
+    {
+        // First fit: walk the free list until a big enough block is found
+        pxPreviousBlock = &xStart;
+        pxBlock = xStart.pxNextFreeBlock;
+        while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->pxNextFreeBlock != NULL ) )
+        {
+            pxPreviousBlock = pxBlock;
+            pxBlock = pxBlock->pxNextFreeBlock;
+        }
+
+        // pxEnd means no block was big enough
+        if( pxBlock != pxEnd )
+        {
+            // Skip the header and remove the block from the free list
+            pvReturn = (void *)( ( (uint8_t *)pxPreviousBlock->pxNextFreeBlock ) + heapSTRUCT_SIZE );
+            pxPreviousBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+
+            // Split the block if the remainder is still useful
+            if( (size_t)( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+            {
+                pxNewBlockLink = (BlockLink_t *)( ( (uint8_t *)pxBlock ) + xWantedSize );
+                pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+                pxBlock->xBlockSize = xWantedSize;
+                vHeapInsertBlockIntoFreeList(pxNewBlockLink);
+            }
+
+            xFreeBytesRemaining -= pxBlock->xBlockSize;
+
+            // Mark as allocated
+            pxBlock->xBlockSize |= heapBLOCK_ALLOCATED_BITMASK;
+            pxBlock->pxNextFreeBlock = NULL;
+        }
+    }
+
+    /* Exit a critical section */
+    portEXIT_CRITICAL();
+
+    return pvReturn;
+}
+
+void vPortFree(void *pvPtr)
+{
+    BlockLink_t *pxLink;
+
+    if( pvPtr == NULL ) return;
+
+    // The header lives just before the returned pointer
+    pxLink = (BlockLink_t *)( ( (uint8_t *)pvPtr ) - heapSTRUCT_SIZE );
+    configASSERT( pxLink->xBlockSize & heapBLOCK_ALLOCATED_BITMASK );
+    configASSERT( pxLink->pxNextFreeBlock == NULL );
+
+    /* Enter a critical section */
+    portENTER_CRITICAL();
+
+    pxLink->xBlockSize &= ~heapBLOCK_ALLOCATED_BITMASK;
+    xFreeBytesRemaining += pxLink->xBlockSize;
+    vHeapInsertBlockIntoFreeList(pxLink);
+
+    /* Exit a critical section */
+    portEXIT_CRITICAL();
+}
+
+uint16_t xPortGetFreeHeapSize(void)
+{
+    if( pxEnd == NULL ) return configTOTAL_HEAP_SIZE - heapSTRUCT_SIZE;
+
+    return xFreeBytesRemaining;
+}
+
+/* Private reference function -------------------------*/
+static void vHeapInit(void)
+{
+    BlockLink_t *pxFirstFreeBlock;
+    uint8_t *pucAlignedHeap = ucHeap;
+    uint16_t xTotalHeapSize = configTOTAL_HEAP_SIZE;
+
+    // Ensure the heap starts on a CPU word boundary
+    if( (uintptr_t)pucAlignedHeap & heapBYTE_ALIGNMENT_MASK )
+    {
+        pucAlignedHeap++;
+        xTotalHeapSize--;
+    }
+    xTotalHeapSize &= ~heapBYTE_ALIGNMENT_MASK;
+
+    // xStart is the head of the list, pxEnd marks its end at the top of the heap
+    xStart.pxNextFreeBlock = (BlockLink_t *)pucAlignedHeap;
+    xStart.xBlockSize = 0;
+    pxEnd = (BlockLink_t *)( pucAlignedHeap + xTotalHeapSize - heapSTRUCT_SIZE );
+    pxEnd->xBlockSize = 0;
+    pxEnd->pxNextFreeBlock = NULL;
+
+    // A single free block spans the whole heap
+    pxFirstFreeBlock = (BlockLink_t *)pucAlignedHeap;
+    pxFirstFreeBlock->xBlockSize = xTotalHeapSize - heapSTRUCT_SIZE;
+    pxFirstFreeBlock->pxNextFreeBlock = pxEnd;
+
+    xFreeBytesRemaining = pxFirstFreeBlock->xBlockSize;
+}
+
+static void vHeapInsertBlockIntoFreeList(BlockLink_t *pxBlockToInsert)
+{
+    BlockLink_t *pxIterator;
+    uint8_t *puc;
+
+    // Find the free block just before the one to insert (the list is sorted by address)
+    for( pxIterator = &xStart; pxIterator->pxNextFreeBlock < pxBlockToInsert; pxIterator = pxIterator->pxNextFreeBlock ) { }
+
+    // Merge with the previous block if they are contiguous
+    puc = (uint8_t *)pxIterator;
+    if( ( puc + pxIterator->xBlockSize ) == (uint8_t *)pxBlockToInsert )
+    {
+        pxIterator->xBlockSize += pxBlockToInsert->xBlockSize;
+        pxBlockToInsert = pxIterator;
+    }
+
+    // Merge with the next block if they are contiguous
+    puc = (uint8_t *)pxBlockToInsert;
+    if( ( puc + pxBlockToInsert->xBlockSize ) == (uint8_t *)pxIterator->pxNextFreeBlock && pxIterator->pxNextFreeBlock != pxEnd )
+    {
+        pxBlockToInsert->xBlockSize += pxIterator->pxNextFreeBlock->xBlockSize;
+        pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock->pxNextFreeBlock;
+    }
+    else
+    {
+        pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock;
+    }
+
+    // Link it, unless it was merged with the previous block
+    if( pxIterator != pxBlockToInsert )
+    {
+        pxIterator->pxNextFreeBlock = pxBlockToInsert;
+    }
+}
+#else
 void *pvPortMalloc(uint16_t xWantedSize)
 {
     void * pvReturn = NULL;
@@ -55,3 +240,4 @@ uint16_t xPortGetFreeHeapSize(void)
 {
     return configTOTAL_HEAP_SIZE - xNextFreeByte;
 }
+#endif
@@ -0,0 +1,201 @@
+/*
+ * UpBasic.c
+ *
+ *  Created on: 6 may 2024
+ *      Author: User123
+ */
+
+/* Private includes -----------------------------------*/
+#include <UpRTOS/UpBasic.h>
+#include <UpRTOS/UpTask.h>
+
+#if configUSE_BASIC_TASKS == (1)
+
+/* Private defines ---------------------------------------------------*/
+#if configUSE_NOTIFICATIONS != (1)
+#error "configUSE_BASIC_TASKS requires configUSE_NOTIFICATIONS"
+#endif
+
+/*
+ * All the basic tasks run on a single UpRTOS task, the dispatcher, so they
+ * share its stack. The dispatcher takes the priority of the basic task it
+ * runs, which puts the basic tasks in the priority order of the full tasks:
+ *
+ *  - While it waits it stays at the highest basic task priority, so an
+ *    activation from an interrupt wakes it up before any task that the
+ *    activated basic task should preempt. It then lowers itself to the
+ *    priority of that basic task before running it.
+ *  - An activation from a task raises the dispatcher right away.
+ *  - Basic tasks do not preempt each other, a running handler completes
+ *    before the next one is selected (highest priority first).
+ */
+
+/* Private macros ----------------------------------------------------*/
+
+/* Private typedefs --------------------------------------------------*/
+
+/* Private prototype function ----------------------------------------*/
+static void vBasicDispatcherTask(void *pvParams);
+static BasicTask_t *pxBasicGetHighestPending(void);
+
+/* Private variables -------------------------------------------------*/
+static BasicTask_t *pxBasicTaskList = NULL;     // Descending priority
+static TaskHandle_t xBasicDispatcherHandle = NULL;
+
+
+/* Reference function ------------------------------------------------*/
+/*!
+ * @name xBasicCreateDispatcher
+ * @brief Create the task that runs the basic tasks, it is called by the
+ *        scheduler on start-up
+ * @return pdTRUE on success
+ */
+UBaseType_t xBasicCreateDispatcher(void)
+{
+    if(xBasicDispatcherHandle != NULL) return pdTRUE;
+
+    return xTaskCreate(vBasicDispatcherTask, configBASIC_STACK_SIZE, NULL, configMAX_PRIORITIES, &xBasicDispatcherHandle);
+}
+
+/*!
+ * @name xBasicTaskCreate
+ * @brief Register a basic task, it runs once per activation
+ * @return pdTRUE on success
+ */
+UBaseType_t xBasicTaskCreate(   BasicTask_t *pxBasicTask,
+                                BasicFunction_t pxFunction,
+                                void *pvParameter,
+                                UBaseType_t uxPriority )
+{
+    BasicTask_t *pxPrevious;
+
+    configASSERT_RETURN(pxBasicTask != NULL && pxFunction != NULL, pdFALSE);
+    configASSERT_RETURN(uxPriority > configIDLE_PRIORITY, pdFALSE);
+
+    // Check priority
+    if(uxPriority > configMAX_PRIORITIES) uxPriority = configMAX_PRIORITIES;
+
+    pxBasicTask->pxFunction = pxFunction;
+    pxBasicTask->pvParameter = pvParameter;
+    pxBasicTask->uxPriority = uxPriority;
+    pxBasicTask->ucActivations = 0;
+
+    // Only tasks change the list
+    vTaskSuspendAll();
+
+    // Insert in descending order, after the others of the same priority
+    if(pxBasicTaskList == NULL || uxPriority > pxBasicTaskList->uxPriority)
+    {
+        pxBasicTask->pxNext = pxBasicTaskList;
+        pxBasicTaskList = pxBasicTask;
+    }
+    else
+    {
+        pxPrevious = pxBasicTaskList;
+        while(pxPrevious->pxNext != NULL && uxPriority <= pxPrevious->pxNext->uxPriority)
+        {
+            pxPrevious = pxPrevious->pxNext;
+        }
+        pxBasicTask->pxNext = pxPrevious->pxNext;
+        pxPrevious->pxNext = pxBasicTask;
+    }
+
+    (void)xTaskResumeAll();
+
+    return pdTRUE;
+}
+
+UBaseType_t xBasicTaskActivate(BasicTask_t *pxBasicTask)
+{
+    configASSERT_RETURN(pxBasicTask != NULL, pdFALSE);
+    configASSERT_RETURN(xBasicDispatcherHandle != NULL, pdFALSE);
+
+    // Interrupts may activate at the same time
+    taskENTER_CRITICAL();
+    if(pxBasicTask->ucActivations == UINT8_MAX)
+    {
+        taskEXIT_CRITICAL();
+        return pdFALSE;
+    }
+    pxBasicTask->ucActivations++;
+    taskEXIT_CRITICAL();
+
+    // Preempt the caller if the basic task runs first
+    if(pxBasicTask->uxPriority > uxTaskPriorityGet(xBasicDispatcherHandle))
+    {
+        vTaskPrioritySet(xBasicDispatcherHandle, pxBasicTask->uxPriority);
+    }
+
+    // Wake-up the dispatcher
+    (void)xTaskNotifyGive(xBasicDispatcherHandle);
+
+    return pdTRUE;
+}
+
+UBaseType_t xBasicTaskActivateFromISR(  BasicTask_t *pxBasicTask,
+                                        UBaseType_t *pxHigherPriorityTaskWoken )
+{
+    configASSERT_RETURN(pxBasicTask != NULL, pdFALSE);
+    configASSERT_RETURN(xBasicDispatcherHandle != NULL, pdFALSE);
+
+    // Interrupts do not nest, so no critical section is required
+    if(pxBasicTask->ucActivations == UINT8_MAX) return pdFALSE;
+    pxBasicTask->ucActivations++;
+
+    // Wake-up the dispatcher, with pxHigherPriorityTaskWoken == NULL it will
+    // run on the next scheduler call
+    vTaskNotifyGiveFromISR(xBasicDispatcherHandle, pxHigherPriorityTaskWoken);
+
+    return pdTRUE;
+}
+
+
+/* Private reference functions -----------------------------------*/
+static BasicTask_t *pxBasicGetHighestPending(void)
+{
+    BasicTask_t *pxBasicTask;
+
+    vTaskSuspendAll();
+    pxBasicTask = pxBasicTaskList;
+    while(pxBasicTask != NULL && pxBasicTask->ucActivations == 0) pxBasicTask = pxBasicTask->pxNext;
+    (void)xTaskResumeAll();
+
+    return pxBasicTask;
+}
+
+static void vBasicDispatcherTask(void *pvParams)
+{
+    BasicTask_t *pxBasicTask;
+
+    (void)pvParams;
+
+    while(1)
+    {
+        pxBasicTask = pxBasicGetHighestPending();
+        if(pxBasicTask == NULL)
+        {
+            // Wait at the highest basic task priority
+            if(pxBasicTaskList != NULL) vTaskPrioritySet(NULL, pxBasicTaskList->uxPriority);
+
+            // An activation made while running leaves the notification
+            // pending, so no activation is lost
+            (void)usTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        // Lowering the priority may let a higher task run first, then a
+        // higher basic task may have been activated meanwhile
+        vTaskPrioritySet(NULL, pxBasicTask->uxPriority);
+        if(pxBasicGetHighestPending() != pxBasicTask) continue;
+
+        // Consume the activation
+        taskENTER_CRITICAL();
+        pxBasicTask->ucActivations--;
+        taskEXIT_CRITICAL();
+
+        // Run to completion
+        pxBasicTask->pxFunction(pxBasicTask->pvParameter);
+    }
+}
+
+#endif /* configUSE_BASIC_TASKS */
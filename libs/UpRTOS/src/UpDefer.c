@@ -0,0 +1,129 @@
+/*
+ * UpDefer.c
+ *
+ *  Created on: 22 abr 2024
+ *      Author: User123
+ */
+
+/* Private includes -----------------------------------*/
+#include <UpRTOS/UpDefer.h>
+#include <UpRTOS/UpTask.h>
+
+#if configUSE_DEFERRED_CALLS == (1)
+
+/* Private defines ---------------------------------------------------*/
+#define deferQUEUE_MASK     (configDEFER_QUEUE_LENGTH - 1)
+
+#if (configDEFER_QUEUE_LENGTH & deferQUEUE_MASK) != 0
+#error "configDEFER_QUEUE_LENGTH must be a power of two"
+#endif
+
+/* Private macros ----------------------------------------------------*/
+
+/* Private typedefs --------------------------------------------------*/
+typedef struct
+{
+    DeferredFunction_t pxFunction;      /**< Function to run in the daemon task */
+    void *pvParameter;                  /**< Argument passed to pxFunction */
+} DeferredCall_t;
+
+/* Private prototype function ----------------------------------------*/
+static void vDeferDaemonTask(void *pvParams);
+static UBaseType_t xDeferPost(DeferredFunction_t pxFunction, void *pvParameter);
+
+/* Private variables -------------------------------------------------*/
+static DeferredCall_t xDeferQueue[configDEFER_QUEUE_LENGTH];
+static volatile UBaseType_t uxDeferWriteIndex = 0;  // Only written by the posting side
+static volatile UBaseType_t uxDeferReadIndex = 0;   // Only written by the daemon task
+static TaskHandle_t xDeferDaemonHandle = NULL;
+
+
+/* Reference function ------------------------------------------------*/
+/*!
+ * @name xDeferCreateDaemon
+ * @brief Create the task that runs the deferred calls, it is called by the
+ *        scheduler on start-up
+ * @return pdTRUE on success
+ */
+UBaseType_t xDeferCreateDaemon(void)
+{
+    if(xDeferDaemonHandle != NULL) return pdTRUE;
+
+    return xTaskCreate(vDeferDaemonTask, configDEFER_TASK_STACK_SIZE, NULL, configDEFER_TASK_PRIORITY, &xDeferDaemonHandle);
+}
+
+UBaseType_t xDeferFunctionCall(DeferredFunction_t pxFunction, void *pvParameter)
+{
+    UBaseType_t xReturn;
+
+    configASSERT_RETURN(pxFunction != NULL, pdFALSE);
+
+    // Tasks and interrupts may post at the same time
+    portENTER_CRITICAL();
+
+    xReturn = xDeferPost(pxFunction, pvParameter);
+
+    portEXIT_CRITICAL();
+
+    // Wake-up the daemon
+    if(xReturn) xTaskNotifyGive(xDeferDaemonHandle);
+
+    return xReturn;
+}
+
+UBaseType_t xDeferFunctionCallFromISR(  DeferredFunction_t pxFunction,
+                                        void *pvParameter,
+                                        UBaseType_t *pxHigherPriorityTaskWoken )
+{
+    configASSERT_RETURN(pxFunction != NULL, pdFALSE);
+
+    // Interrupts do not nest, so no critical section is required
+    if( !xDeferPost(pxFunction, pvParameter) ) return pdFALSE;
+
+    // Wake-up the daemon, with pxHigherPriorityTaskWoken == NULL it will run
+    // on the next scheduler call
+    vTaskNotifyGiveFromISR(xDeferDaemonHandle, pxHigherPriorityTaskWoken);
+
+    return pdTRUE;
+}
+
+
+/* Private reference functions -----------------------------------*/
+static UBaseType_t xDeferPost(DeferredFunction_t pxFunction, void *pvParameter)
+{
+    // Check if the ring is full
+    if( (UBaseType_t)(uxDeferWriteIndex - uxDeferReadIndex) >= configDEFER_QUEUE_LENGTH ) return pdFALSE;
+    configASSERT_RETURN(xDeferDaemonHandle != NULL, pdFALSE);
+
+    DeferredCall_t *pxCall = &xDeferQueue[uxDeferWriteIndex & deferQUEUE_MASK];
+    pxCall->pxFunction = pxFunction;
+    pxCall->pvParameter = pvParameter;
+
+    // Publish the entry once it is complete
+    uxDeferWriteIndex++;
+
+    return pdTRUE;
+}
+
+static void vDeferDaemonTask(void *pvParams)
+{
+    (void)pvParams;
+
+    while(1)
+    {
+        // A call posted while the queue was being drained leaves the
+        // notification pending, so no call is lost
+        usTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while(uxDeferReadIndex != uxDeferWriteIndex)
+        {
+            DeferredCall_t *pxCall = &xDeferQueue[uxDeferReadIndex & deferQUEUE_MASK];
+            pxCall->pxFunction(pxCall->pvParameter);
+
+            // Release the slot
+            uxDeferReadIndex++;
+        }
+    }
+}
+
+#endif /* configUSE_DEFERRED_CALLS */
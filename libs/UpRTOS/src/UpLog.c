@@ -0,0 +1,166 @@
+/*
+ * UpLog.c
+ *
+ *  Created on: 14 may 2024
+ *      Author: User123
+ */
+
+/* Private includes -----------------------------------*/
+#include <UpRTOS/UpLog.h>
+#include <UpRTOS/UpTask.h>
+#include <stdarg.h>
+
+#if configUSE_TOKEN_LOG == (1)
+
+/* Private defines ---------------------------------------------------*/
+#define logBUFFER_MASK      (configLOG_BUFFER_SIZE - 1)
+#define logRECORD_MAX_SIZE  (logRECORD_HEADER_SIZE + 2*configLOG_MAX_ARGS)
+
+#if (configLOG_BUFFER_SIZE & logBUFFER_MASK) != 0
+#error "configLOG_BUFFER_SIZE must be a power of two"
+#endif
+#if configLOG_BUFFER_SIZE < logRECORD_MAX_SIZE
+#error "configLOG_BUFFER_SIZE must hold a record of configLOG_MAX_ARGS arguments"
+#endif
+
+/* Private macros ----------------------------------------------------*/
+
+/* Private typedefs --------------------------------------------------*/
+
+/* Private prototype function ----------------------------------------*/
+static void vLogDaemonTask(void *pvParams);
+static UBaseType_t uxLogHeader(uint8_t *pucRecord, UBaseType_t uxId, UBaseType_t uxArgs);
+
+/* Private variables -------------------------------------------------*/
+static uint8_t ucLogBuffer[configLOG_BUFFER_SIZE];
+static volatile UBaseType_t uxLogWriteIndex = 0;    // Only written by vLogWrite
+static volatile UBaseType_t uxLogReadIndex = 0;     // Only written by the daemon task
+static volatile UBaseType_t uxLogDropped = 0;
+static LogOutput_t pxLogOutput = NULL;
+static TaskHandle_t xLogDaemonHandle = NULL;
+
+
+/* Reference function ------------------------------------------------*/
+/*!
+ * @name xLogCreateDaemon
+ * @brief Create the task that drains the log buffer into pxOutput
+ * @return pdTRUE on success
+ */
+UBaseType_t xLogCreateDaemon(LogOutput_t pxOutput)
+{
+    configASSERT_RETURN(pxOutput != NULL, pdFALSE);
+
+    pxLogOutput = pxOutput;
+    if(xLogDaemonHandle != NULL) return pdTRUE;
+
+    return xTaskCreate(vLogDaemonTask, configLOG_TASK_STACK_SIZE, NULL, configLOG_TASK_PRIORITY, &xLogDaemonHandle);
+}
+
+/*!
+ * @name vLogWrite
+ * @brief Store a record, called through logWRITE. A record that does not
+ *        fit is dropped whole and counted, the caller never waits.
+ */
+void vLogWrite(UBaseType_t uxArgs, UBaseType_t uxId, ...)
+{
+    uint8_t ucRecord[logRECORD_MAX_SIZE];
+    UBaseType_t uxLength;
+    UBaseType_t uxIndex;
+    UBaseType_t uxValue;
+    va_list xArgs;
+
+    configASSERT(uxArgs <= configLOG_MAX_ARGS);
+
+    // Build the record outside of the critical section
+    uxLength = uxLogHeader(ucRecord, uxId, uxArgs);
+    va_start(xArgs, uxId);
+    while(uxArgs--)
+    {
+        uxValue = (UBaseType_t)va_arg(xArgs, unsigned int);
+        ucRecord[uxLength++] = (uint8_t)uxValue;
+        ucRecord[uxLength++] = (uint8_t)(uxValue >> 8);
+    }
+    va_end(xArgs);
+
+    // Tasks and interrupts may log at the same time
+    portENTER_CRITICAL();
+
+    if( (UBaseType_t)(configLOG_BUFFER_SIZE - (uxLogWriteIndex - uxLogReadIndex)) < uxLength )
+    {
+        uxLogDropped++;
+    }
+    else
+    {
+        uxIndex = uxLogWriteIndex;
+        for(UBaseType_t i = 0; i < uxLength; i++)
+        {
+            ucLogBuffer[uxIndex++ & logBUFFER_MASK] = ucRecord[i];
+        }
+
+        // Publish the record once it is complete
+        uxLogWriteIndex = uxIndex;
+    }
+
+    portEXIT_CRITICAL();
+}
+
+
+/* Private reference functions -----------------------------------*/
+static UBaseType_t uxLogHeader(uint8_t *pucRecord, UBaseType_t uxId, UBaseType_t uxArgs)
+{
+    UBaseType_t uxTicks = (UBaseType_t)xTaskGetTickCount();
+
+    pucRecord[0] = (uint8_t)uxId;
+    pucRecord[1] = (uint8_t)uxArgs;
+    pucRecord[2] = (uint8_t)uxTicks;
+    pucRecord[3] = (uint8_t)(uxTicks >> 8);
+
+    return logRECORD_HEADER_SIZE;
+}
+
+static void vLogDaemonTask(void *pvParams)
+{
+    uint8_t ucRecord[logRECORD_MAX_SIZE];
+    UBaseType_t uxLength;
+    UBaseType_t uxDropped;
+
+    (void)pvParams;
+
+    while(1)
+    {
+        // Records are batched, the loggers never wake this task
+        vTaskDelay(configLOG_DRAIN_PERIOD);
+
+        while(uxLogReadIndex != uxLogWriteIndex)
+        {
+            UBaseType_t uxIndex = uxLogReadIndex;
+
+            uxLength = logRECORD_HEADER_SIZE + 2*ucLogBuffer[(uxIndex + 1) & logBUFFER_MASK];
+            for(UBaseType_t i = 0; i < uxLength; i++)
+            {
+                ucRecord[i] = ucLogBuffer[uxIndex++ & logBUFFER_MASK];
+            }
+
+            // Release the slot before the (slow) output
+            uxLogReadIndex = uxIndex;
+
+            pxLogOutput(ucRecord, uxLength);
+        }
+
+        // Drops happen while the buffer is full, so after what was just sent
+        portENTER_CRITICAL();
+        uxDropped = uxLogDropped;
+        uxLogDropped = 0;
+        portEXIT_CRITICAL();
+
+        if(uxDropped)
+        {
+            uxLength = uxLogHeader(ucRecord, LOG_ID_DROPPED, 1);
+            ucRecord[uxLength++] = (uint8_t)uxDropped;
+            ucRecord[uxLength++] = (uint8_t)(uxDropped >> 8);
+            pxLogOutput(ucRecord, uxLength);
+        }
+    }
+}
+
+#endif /* configUSE_TOKEN_LOG */
@@ -34,7 +34,7 @@ typedef struct
 MutexHandle_t xMutexCreate(void)
 {
     Mutex_t *pxMutex = NULL;
-    portENTER_CRITICAL();
+    taskENTER_CRITICAL();
     pxMutex = (Mutex_t *)pvPortMalloc(sizeof(Mutex_t));
     if(pxMutex != NULL)
     {
@@ -43,21 +43,19 @@ MutexHandle_t xMutexCreate(void)
         vListCreateStatic(&pxMutex->xTasksWaitingToHold);
         pxMutex->xTaskHolder = NULL;
     }
-    portEXIT_CRITICAL();
+    taskEXIT_CRITICAL();
 
     return (MutexHandle_t)pxMutex;
 }
 
 UBaseType_t xMutexTake(MutexHandle_t hMutex, TickType_t xTicksToWait)
 {
-    // The sr needs saving before it is modified.
-    portSAVE_CPU_STATUS();
 
     UBaseType_t xReturn = pdTRUE;
     Mutex_t *pxMutex = (Mutex_t *)hMutex;
 
     // Enter a critical section
-    portENTER_CRITICAL();
+    taskENTER_CRITICAL();
 
     if( pxMutex->uxLock )
     {
@@ -87,24 +85,19 @@ UBaseType_t xMutexTake(MutexHandle_t hMutex, TickType_t xTicksToWait)
     }
 
 
-    portEXIT_CRITICAL();
-
-    // The sr needs restoring after returning to this task
-    portRESTORE_CPU_STATUS();
+    taskEXIT_CRITICAL();
 
     return xReturn;
 }
 
 UBaseType_t xMutexGive(MutexHandle_t hMutex)
 {
-    // The sr needs saving before it is modified.
-    portSAVE_CPU_STATUS();
 
     UBaseType_t xReturn = pdFALSE;
     Mutex_t *pxMutex = (Mutex_t *)hMutex;
 
     // Critical section
-    portENTER_CRITICAL();
+    taskENTER_CRITICAL();
 
     // Check if the current task is the task that took the mutex
     if(xTaskGetCurrentTaskHandle() == pxMutex->xTaskHolder )
@@ -113,18 +106,21 @@ UBaseType_t xMutexGive(MutexHandle_t hMutex)
         pxMutex->uxLock = 0;
         pxMutex->xTaskHolder = NULL;
 
-        // Check if there is any pending task trying to take the mutex
-        if(pxMutex->xTasksWaitingToHold.uxNumberOfItems)
-        {
-            // Yield
-            vTaskYieldFromEventList(&pxMutex->xTasksWaitingToHold);
-        }
-
         xReturn = pdTRUE;
     }
-    portEXIT_CRITICAL();
 
-    //
-    portRESTORE_CPU_STATUS();
+    // The scheduler lock keeps other tasks away from the mutex while the
+    // waiting list is walked with interrupts enabled
+    vTaskSuspendAll();
+    taskEXIT_CRITICAL();
+
+    // Check if there is any pending task trying to take the mutex
+    if(xReturn && pxMutex->xTasksWaitingToHold.uxNumberOfItems)
+    {
+        // Yield
+        vTaskYieldFromEventList(&pxMutex->xTasksWaitingToHold);
+    }
+
+    (void)xTaskResumeAll();
     return xReturn;
 }
@@ -8,6 +8,7 @@
 
 /* Private includes -----------------------------------*/
 #include <UpRTOS/UpPortable.h>
+#include <UpRTOS/UpTask.h>
 
 /* Private defines ---------------------------------------------------*/
 
@@ -21,6 +22,17 @@
 
 
 /* Private variables -------------------------------------------------*/
+volatile UBaseType_t uxCriticalNesting = portINITIAL_CRITICAL_NESTING;
+#if configUSE_ISR_STACK == (1)
+static StackType_t xPortISRStack[configISR_STACK_SIZE >> 1];
+StackType_t * const pxPortISRStackTop = &xPortISRStack[configISR_STACK_SIZE >> 1];
+volatile UBaseType_t uxPortISRNesting = 0;
+#endif
+static volatile UBaseType_t uxPortYieldPending = pdFALSE;   // Systick raised by vPortYieldFromISR
+static volatile uint16_t usPortYieldTimerCount = 0;         // TA1R when the yield was requested
+#if configGENERATE_RUN_TIME_STATS == (1)
+static volatile uint32_t ulPortRunTimeBase = 0;             // Run time at the last Systick period
+#endif
 
 
 
@@ -59,9 +71,98 @@ UBaseType_t xPortSetuptTimerInterrupt(void)
 
 
 
+/*!
+ * @name vPortYieldFromISR
+ * @brief Request a context switch when the running ISR returns. It raises
+ *        the Systick interrupt by software, which saves the interrupted
+ *        task and runs the scheduler.
+ */
+void vPortYieldFromISR(void)
+{
+    // A pending tick switches context anyway
+    if( !(TA1CCTL0 & BIT0) )
+    {
+        usPortYieldTimerCount = TA1R;
+        uxPortYieldPending = pdTRUE;
+        TA1CCTL0 |= BIT0;   // Set CC0IFG
+    }
+}
+
+/*!
+ * @name xPortTickPending
+ * @brief Check if the Systick period expired and its interrupt has not run
+ *        yet, CC0IFG raised by vPortYieldFromISR alone is not a tick.
+ *        Interrupts must be disabled.
+ */
+UBaseType_t xPortTickPending(void)
+{
+    if( !(TA1CCTL0 & BIT0) ) return pdFALSE;
+
+    // Same test as vPortTickHandler: a tick merged into the yield
+    return ( !uxPortYieldPending || TA1R < usPortYieldTimerCount );
+}
+
+/*!
+ * @name vPortTickHandler
+ * @brief Called by Systick_IRQHandler once the interrupted task is saved
+ */
+void vPortTickHandler(void)
+{
+    UBaseType_t xTick = pdTRUE;
+
+    if( uxPortYieldPending )
+    {
+        uxPortYieldPending = pdFALSE;
+
+        // The counter only goes below the recorded count if the period
+        // expired after the request, then the real tick was merged into it
+        if( TA1R >= usPortYieldTimerCount ) xTick = pdFALSE;
+    }
+
+    if( xTick )
+    {
+#if configGENERATE_RUN_TIME_STATS == (1)
+        // Kept apart from xTickCount, which stops while the scheduler is suspended
+        ulPortRunTimeBase += (uint32_t)( ((uint32_t)TA1CCR0 + 1) >> portRUN_TIME_COUNTER_SHIFT );
+#endif
+        vTaskIncrementTick();
+    }
+    vTaskSwitchContext();
+}
+
+#if configGENERATE_RUN_TIME_STATS == (1)
+/*!
+ * @name ulPortGetRunTimeCounterValue
+ * @brief Free running time base for the run time stats, it wraps around
+ *        (every 71 minutes at 16 MHz)
+ * @return Time in 2^portRUN_TIME_COUNTER_SHIFT Systick timer clocks
+ */
+uint32_t ulPortGetRunTimeCounterValue(void)
+{
+    uint32_t ulReturn;
+
+    portENTER_CRITICAL();
+
+    ulReturn = ulPortRunTimeBase + (TA1R >> portRUN_TIME_COUNTER_SHIFT);
+
+    // The period expired but the Systick has not run yet (interrupts masked)
+    if( xPortTickPending() )
+    {
+        ulReturn += ((uint32_t)TA1CCR0 + 1) >> portRUN_TIME_COUNTER_SHIFT;
+    }
+
+    portEXIT_CRITICAL();
+
+    return ulReturn;
+}
+#endif
+
+
+
 /* Private reference functions -----------------------------------*/
 StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters)
 {
+    // Full context frame (see UpPortable.asm), so bit 0 of the returned pointer is left clear
     *pxTopOfStack-- = (StackType_t)( pxCode );      // PC
     *pxTopOfStack-- = portINT_ENABLED_MASK;        // Status Register
     *pxTopOfStack-- = 0xFFFF;                       // R15
@@ -75,7 +176,8 @@ StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxC
     *pxTopOfStack-- = 0x7777;                       // R7
     *pxTopOfStack-- = 0x6666;                       // R6
     *pxTopOfStack-- = 0x5555;                       // R5
-    *pxTopOfStack   = 0x4444;                       // R4
+    *pxTopOfStack-- = 0x4444;                       // R4
+    *pxTopOfStack   = 0;                            // Critical nesting
 
     return pxTopOfStack;
 }
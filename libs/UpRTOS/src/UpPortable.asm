@@ -0,0 +1,192 @@
+;******************************************************************************
+; @file       UpPortable.asm
+; @author     Fernando Hermosillo Reynoso
+; @brief      UpRTOS port layer for the MSP430 (context switch, scheduler
+;             entry and Systick interrupt)
+;******************************************************************************
+; @attention
+;
+; Copyright (c) 2024 Universidad Panamericana.
+; All rights reserved.
+;
+; This software is licensed under terms that can be found in the LICENSE file in
+; the root directory of this software component.
+; If no LICENSE file comes with this software, it is provided AS-IS.
+;
+;******************************************************************************
+;
+; Context frames (lower address first, pxTopOfStack points to NEST, the
+; uxCriticalNesting of the task):
+;
+;  - Full frame, on preemption (Systick) and for new tasks
+;    (pxPortInitialiseStack):
+;       NEST R4 R5 R6 R7 R8 R9 R10 R11 R12 R13 R14 R15 SR PC    (30 bytes)
+;
+;  - Yield frame, when a task calls vPortYield. The C ABI lets the callee
+;    clobber R12-R15, so only R4-R11 are kept:
+;       NEST R4 R5 R6 R7 R8 R9 R10 R11 SR PC                    (22 bytes)
+;
+; SP is always even, so bit 0 of the saved pxTopOfStack tags a yield frame.
+; Both frames end with SR/PC, so both are resumed with reti.
+;
+; vTaskSwitchContext (C) runs on the stack of the outgoing task, below its
+; saved frame, and only updates pxCurrentTCB.
+;
+;******************************************************************************
+            .cdecls C,NOLIST,"UpRTOSConfig.h"
+
+            .global pxCurrentTCB
+            .global uxCriticalNesting
+            .global vTaskSwitchContext
+            .global vPortTickHandler
+
+            .global vPortStartFirstTask
+            .global vPortYield
+            .global Systick_IRQHandler
+            .if configUSE_ISR_STACK == 1
+            .global pxPortISRStackTop
+            .global uxPortISRNesting
+            .global vPortRunOnISRStack
+            .endif
+
+portYIELD_FRAME_TAG     .set    0x0001
+
+
+;------------------------------------------------------------------------------
+; Save the full frame of the current task (PC and SR already on the stack)
+;------------------------------------------------------------------------------
+portSAVE_CONTEXT    .macro
+            push.w  R15
+            push.w  R14
+            push.w  R13
+            push.w  R12
+            push.w  R11
+            push.w  R10
+            push.w  R9
+            push.w  R8
+            push.w  R7
+            push.w  R6
+            push.w  R5
+            push.w  R4
+            push.w  &uxCriticalNesting
+            mov.w   &pxCurrentTCB, R15
+            mov.w   SP, 0(R15)
+            .endm
+
+
+            .text
+;------------------------------------------------------------------------------
+; void vPortStartFirstTask(void)
+; Resume pxCurrentTCB, never returns
+;------------------------------------------------------------------------------
+vPortStartFirstTask:
+            jmp     vPortRestoreContext
+
+
+;------------------------------------------------------------------------------
+; void vPortYield(void)
+; Save a yield frame, select the next task and resume it. The caller keeps
+; the interrupt state it had on entry once it is resumed.
+;------------------------------------------------------------------------------
+vPortYield:
+            push.w  SR
+            dint
+            nop
+            push.w  R11
+            push.w  R10
+            push.w  R9
+            push.w  R8
+            push.w  R7
+            push.w  R6
+            push.w  R5
+            push.w  R4
+            push.w  &uxCriticalNesting
+            mov.w   &pxCurrentTCB, R15
+            mov.w   SP, 0(R15)
+            bis.w   #portYIELD_FRAME_TAG, 0(R15)
+            call    #vTaskSwitchContext
+            ; Falls through
+
+
+;------------------------------------------------------------------------------
+; Resume pxCurrentTCB from either frame type
+; (SP bit 0 is hardwired to zero, so the tag is tested before loading SP)
+;------------------------------------------------------------------------------
+vPortRestoreContext:
+            mov.w   &pxCurrentTCB, R15
+            mov.w   0(R15), R14
+            bit.w   #portYIELD_FRAME_TAG, R14
+            jnz     vPortRestoreYieldFrame
+            mov.w   R14, SP
+            pop.w   &uxCriticalNesting
+            pop.w   R4
+            pop.w   R5
+            pop.w   R6
+            pop.w   R7
+            pop.w   R8
+            pop.w   R9
+            pop.w   R10
+            pop.w   R11
+            pop.w   R12
+            pop.w   R13
+            pop.w   R14
+            pop.w   R15
+            reti
+
+vPortRestoreYieldFrame:
+            bic.w   #portYIELD_FRAME_TAG, R14
+            mov.w   R14, SP
+            pop.w   &uxCriticalNesting
+            pop.w   R4
+            pop.w   R5
+            pop.w   R6
+            pop.w   R7
+            pop.w   R8
+            pop.w   R9
+            pop.w   R10
+            pop.w   R11
+            reti
+
+
+;------------------------------------------------------------------------------
+; Systick (TA1 CCR0), also raised by software for vPortYieldFromISR
+;------------------------------------------------------------------------------
+Systick_IRQHandler:
+            portSAVE_CONTEXT
+            call    #vPortTickHandler
+            jmp     vPortRestoreContext
+
+
+            .if configUSE_ISR_STACK == 1
+;------------------------------------------------------------------------------
+; void vPortRunOnISRStack(TaskFunction_t pxHandler, void *pvParameter)
+; Call pxHandler(pvParameter) on the shared interrupt stack, so the task
+; stacks only hold the interrupt entry frame. Must be called from an ISR
+; (interrupts disabled). A nested call stays on the interrupt stack.
+;------------------------------------------------------------------------------
+vPortRunOnISRStack:
+            tst.w   &uxPortISRNesting
+            jnz     $1
+            mov.w   SP, R14                 ; Interrupted task SP
+            mov.w   &pxPortISRStackTop, SP
+            push.w  R14
+            inc.w   &uxPortISRNesting
+            mov.w   R12, R15                ; pxHandler
+            mov.w   R13, R12                ; pvParameter
+            call    R15
+            dec.w   &uxPortISRNesting
+            pop.w   SP                      ; Back to the task stack
+            ret
+$1:         mov.w   R12, R15
+            mov.w   R13, R12
+            br      R15                     ; Already on the ISR stack
+            .endif
+
+
+;------------------------------------------------------------------------------
+; Interrupt vectors
+;------------------------------------------------------------------------------
+            .sect   ".int13"                ; TIMER1_A0_VECTOR
+            .short  Systick_IRQHandler
+
+            .end
@@ -44,7 +44,7 @@ typedef struct
 QueueHandle_t xQueueCreate(uint8_t ucNumItems, uint8_t ucSizePerItem)
 {
     Queue_t *pxQueue = NULL;
-    portENTER_CRITICAL();
+    taskENTER_CRITICAL();
     pxQueue = (Queue_t *)pvPortMalloc(sizeof(Queue_t));
     if(pxQueue != NULL)
     {
@@ -52,7 +52,13 @@ QueueHandle_t xQueueCreate(uint8_t ucNumItems, uint8_t ucSizePerItem)
         //pxQueue->cRxLock = 0;
         //pxQueue->cTxLock = 0;
         pxQueue->pucHead = (uint8_t *)pvPortMalloc(uiQueueTotalSize);
-        if(pxQueue->pucHead == NULL) return NULL;
+        if(pxQueue->pucHead == NULL)
+        {
+            // Leave the critical section balanced
+            vPortFree(pxQueue);
+            taskEXIT_CRITICAL();
+            return NULL;
+        }
         pxQueue->uxItemSize = ucSizePerItem;
         pxQueue->uxLength = ucNumItems;
         pxQueue->pucTail = pxQueue->pucHead + uiQueueTotalSize;
@@ -62,20 +68,18 @@ QueueHandle_t xQueueCreate(uint8_t ucNumItems, uint8_t ucSizePerItem)
         vListCreateStatic(&pxQueue->xTasksWaitingToReceive);
         pxQueue->uxMessagesWaiting = 0;
     }
-    portEXIT_CRITICAL();
+    taskEXIT_CRITICAL();
 
     return pxQueue;
 }
 
 UBaseType_t xQueueSend(QueueHandle_t hQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
 {
-    // The sr needs saving before it is modified.
-    portSAVE_CPU_STATUS();
 
     UBaseType_t xReturn = pdTRUE;
 
     // Enter a critical section
-    portENTER_CRITICAL();
+    taskENTER_CRITICAL();
 
     Queue_t *pxQueue = (Queue_t *)hQueue;
     if( pxQueue->uxMessagesWaiting == pxQueue->uxLength)
@@ -103,28 +107,27 @@ UBaseType_t xQueueSend(QueueHandle_t hQueue, const void *pvItemToQueue, TickType
             pxQueue->pucWriteTo = pxQueue->pucHead;
         }
         pxQueue->uxMessagesWaiting++;
-
-        // Wake-up tasks waiting to receive
-        vTaskYieldFromEventList(&pxQueue->xTasksWaitingToReceive);
     }
 
+    // The scheduler lock keeps other tasks away from the queue while the
+    // waiting list is walked with interrupts enabled
+    vTaskSuspendAll();
+    taskEXIT_CRITICAL();
 
-    portEXIT_CRITICAL();
+    // Wake-up tasks waiting to receive
+    if(xReturn) vTaskYieldFromEventList(&pxQueue->xTasksWaitingToReceive);
 
-    // The sr needs restoring after returning to this task
-    portRESTORE_CPU_STATUS();
+    (void)xTaskResumeAll();
 
     return xReturn;
 }
 
 UBaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait)
 {
-    // The sr needs saving before it is modified.
-    portSAVE_CPU_STATUS();
 
     UBaseType_t xReturn = pdTRUE;
     // Enter a critical section
-    portENTER_CRITICAL();
+    taskENTER_CRITICAL();
 
     Queue_t *pxQueue = (Queue_t *)xQueue;
     if( pxQueue->uxMessagesWaiting == 0)
@@ -152,16 +155,39 @@ UBaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTick
         }
         memcpy(( void * )pvBuffer, ( void * )pxQueue->pucReadFrom, pxQueue->uxItemSize );
         pxQueue->uxMessagesWaiting--;
-
-        // Wake-up tasks waiting to send
-        vTaskYieldFromEventList(&pxQueue->xTasksWaitingToSend);
     }
 
+    // The scheduler lock keeps other tasks away from the queue while the
+    // waiting list is walked with interrupts enabled
+    vTaskSuspendAll();
+    taskEXIT_CRITICAL();
 
-    portEXIT_CRITICAL();
+    // Wake-up tasks waiting to send
+    if(xReturn) vTaskYieldFromEventList(&pxQueue->xTasksWaitingToSend);
 
-    // The sr needs restoring after returning to this task
-    portRESTORE_CPU_STATUS();
+    (void)xTaskResumeAll();
 
     return xReturn;
 }
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue)
+{
+    configASSERT_RETURN(xQueue != NULL, 0);
+
+    // A single word read, it needs no critical section
+    return ((Queue_t *)xQueue)->uxMessagesWaiting;
+}
+
+UBaseType_t uxQueueSpacesAvailable(const QueueHandle_t xQueue)
+{
+    UBaseType_t uxReturn;
+    Queue_t *pxQueue = (Queue_t *)xQueue;
+
+    configASSERT_RETURN(pxQueue != NULL, 0);
+
+    taskENTER_CRITICAL();
+    uxReturn = pxQueue->uxLength - pxQueue->uxMessagesWaiting;
+    taskEXIT_CRITICAL();
+
+    return uxReturn;
+}
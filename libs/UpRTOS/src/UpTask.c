@@ -9,6 +9,8 @@
 /* Private includes -----------------------------------*/
 #include <UpRTOS/UpTask.h>
 #include <UpRTOS/UpList.h>
+#include <UpRTOS/UpDefer.h>
+#include <UpRTOS/UpBasic.h>
 
 /* Private defines ---------------------------------------------------*/
 #define osIDLE_TASK_SET     0x01
@@ -16,73 +18,46 @@
 #define osSCHEDULER_RUNNING 0x40
 #define osTICK_OVERFLOW     0x20
 
+#define taskNOT_WAITING_NOTIFICATION    0x00
+#define taskWAITING_NOTIFICATION        0x01
+#define taskNOTIFICATION_RECEIVED       0x02
+
+#if configMAX_TASKS > 16
+#error "configMAX_TASKS must fit in the task ID bitmap (16 tasks)"
+#endif
+
+#if configUSE_TASK_DELETE == (1) && configUSE_HEAP_FREE != (1)
+#error "configUSE_TASK_DELETE requires configUSE_HEAP_FREE"
+#endif
+
+#if configGENERATE_RUN_TIME_STATS == (1) && configUSE_TRACE_FACILITY != (1)
+#error "configGENERATE_RUN_TIME_STATS requires configUSE_TRACE_FACILITY"
+#endif
+
+#define tskSTACK_FILL_WORD  (0xA5A5)    // Pattern of the unused stack, for the high-water mark
+
 /* Private macros ----------------------------------------------------*/
 #define osCHECK_FLAG(REG,FLAG)  ((REG) & FLAG)
 
-// Save current task stack pointer
-#define portSAVE_CONTEXT()      asm(" push R15\n");\
-                                asm(" push R14\n");\
-                                asm(" push R13\n");\
-                                asm(" push R12\n");\
-                                asm(" push R11\n");\
-                                asm(" push R10\n");\
-                                asm(" push R9\n");\
-                                asm(" push R8\n");\
-                                asm(" push R7\n");\
-                                asm(" push R6\n");\
-                                asm(" push R5\n");\
-                                asm(" push R4\n");\
-                                asm(" mov.w &pxCurrentTCB,R15\n");\
-                                asm(" mov.w SP,0(R15)\n");
-
-
-// Restore current task stack pointer
-#define portRESTORE_CONTEXT()   asm(" mov.w &pxCurrentTCB,R15 \n");\
-                                asm(" mov.w 0(R15),SP \n");\
-                                asm(" nop \n ");\
-                                asm(" pop R4\n");\
-                                asm(" pop R5\n");\
-                                asm(" pop R6\n");\
-                                asm(" pop R7\n");\
-                                asm(" pop R8\n");\
-                                asm(" pop R9\n");\
-                                asm(" pop R10\n");\
-                                asm(" pop R11\n");\
-                                asm(" pop R12\n");\
-                                asm(" pop R13\n");\
-                                asm(" pop R14\n");\
-                                asm(" pop R15\n");\
-                                asm(" reti\n");
-
-#define portSAVE_CONTEXT_FROM_ISR() asm(" pop &pxAuxTCB");\
-                                    asm(" push R9\n");\
-                                    asm(" push R8\n");\
-                                    asm(" push R7\n");\
-                                    asm(" push R6\n");\
-                                    asm(" push R5\n");\
-                                    asm(" push R4\n");\
-                                    asm(" mov.w &pxCurrentTCB,R15\n");\
-                                    asm(" mov.w SP,0(R15)\n");\
-                                    asm(" push &pxAuxTCB");
-
-#define portCALL_SCHEDULER_FROM_ISR()   asm(" mov.w &pxTopOfSchStack, R15\n");\
-                                        asm(" mov.w R15, SP \n");\
-                                        asm(" reti\n");
+// Wake time reached, safe across xTickCount overflow for delays up to half the tick range
+#define taskWAKE_TIME_REACHED(xTimeToWake)  ( (TickType_t)(xTickCount - (xTimeToWake)) <= (portMAX_DELAY >> 1) )
 
 /* Private typedefs --------------------------------------------------*/
-typedef enum {
-    TASK_RUNNING = 0,
-    TASK_READY,
-    TASK_SUSPENDED,
-    TASK_BLOCKED
-} eTaskState;
-
 struct tcb
 {
     StackType_t *pxTopOfStack; /*!< For scheduling mechanism */
 #if configSTACK_ENHANCED == (1)
     StackType_t *pxEndOfStack;
     StackType_t *pxBeginOfStack;
+#endif
+#if configUSE_TASK_DELETE == (1) || configUSE_TRACE_FACILITY == (1)
+    StackType_t *pxStack;               /*!< Start of the stack allocation, returned to the heap on deletion */
+#endif
+#if configUSE_TRACE_FACILITY == (1)
+    uint16_t usStackDepth;              /*!< For introspection, stack size in bytes */
+#endif
+#if configGENERATE_RUN_TIME_STATS == (1)
+    uint32_t ulRunTimeCounter;          /*!< For introspection, time spent running */
 #endif
     UBaseType_t uxId;                   /*!< For scheduling mechanism */
     UBaseType_t uxPriority;             /*!< For scheduling mechanism */
@@ -91,8 +66,16 @@ struct tcb
     UBaseType_t uxStatus;               /*!< For timing constraints TODO: Can be omitted by checking overflow or set task to suspended on case of portMAX_DELAY */
     TickType_t xTimeToWake;             /*!< For timing constraints */
 
+#if configUSE_EDF_SCHEDULING == (1)
+    TickType_t xPeriod;                 /*!< For EDF scheduling (0: aperiodic) */
+    TickType_t xRelativeDeadline;       /*!< For EDF scheduling (0: no deadline, fixed priority only) */
+    TickType_t xReleaseTime;            /*!< For EDF scheduling, release of the current job */
+    TickType_t xAbsoluteDeadline;       /*!< For EDF scheduling, deadline of the current job */
+#endif
+
 #if ( configUSE_NOTIFICATIONS == 1 )
-    uint16_t xNotificationValue;        /*!< For notifications */
+    uint16_t xNotificationValue[configTASK_NOTIFICATION_ARRAY_ENTRIES]; /*!< For notifications */
+    uint8_t ucNotifyState[configTASK_NOTIFICATION_ARRAY_ENTRIES];       /*!< For notifications (pending state) */
 #endif
 
     ListNode_t xEventListItem;          /*!< For mutex and queues */
@@ -103,9 +86,22 @@ typedef struct tcb tcb_t;
 
 
 /* Private prototype function ----------------------------------------*/
-static void vTaskSwitchContext(void);
 static void vTaskIdleHook(void *pvParams);
 static void vTaskRun(tcb_t *pxTaskToRun);
+static void vTaskSetTimeToWake(const TickType_t xTicksToWait);
+static UBaseType_t xTaskPrecedes(const tcb_t *pxTCB, const tcb_t *pxOtherTCB);
+#if ( configUSE_NOTIFICATIONS == 1 )
+static uint8_t ucTaskNotifyUpdate(tcb_t *pxTCB, UBaseType_t uxIndexToNotify, uint16_t usValue, eNotifyAction eAction);
+#endif
+static void vTaskInsertTCB(tcb_t *pxTCB);
+static void vTaskUnlinkTCB(tcb_t *pxTCB);
+#if configUSE_TASK_DELETE == (1)
+static void vTaskFreeTCB(tcb_t *pxTCB);
+static void vTaskCheckTasksWaitingTermination(void);
+#endif
+#if configUSE_TRACE_FACILITY == (1)
+static void vTaskGetStatus(const tcb_t *pxTCB, TaskStatus_t *pxTaskStatus);
+#endif
 
 
 /* Private variables -------------------------------------------------*/
@@ -115,11 +111,20 @@ tcb_t *pxAuxTCB = NULL;         // Auxiliary TCB
 static TaskHandle_t xIdleTaskHandle = NULL; // Idle task TCB
 
 UBaseType_t uxCurrentNumberOfTasks = 0;
+static UBaseType_t uxTaskIdBitmap = 0x0000;     // Bit n is set while task ID n is in use
+#if configUSE_TASK_DELETE == (1)
+static tcb_t *pxTasksWaitingTermination = NULL; // Self-deleted tasks, freed by the idle task
+#endif
 volatile TickType_t xTickCount = 0;
 UBaseType_t uxSchedulerFlags = 0x00;
 //static volatile BaseType_t xNumOfOverflows = ( BaseType_t ) 0;
-static StackType_t xScheduleStack[2] = {0x0000, 0x0000};
-static StackType_t *pxTopOfSchStack = NULL;
+static tcb_t *pxTaskToRunNext = NULL;   // Set by vTaskRun to switch without scanning
+static volatile UBaseType_t uxSchedulerSuspended = 0;   // vTaskSuspendAll nesting
+static volatile TickType_t xPendedTicks = 0;            // Ticks that arrived while suspended
+static volatile UBaseType_t xYieldPending = pdFALSE;    // Switch held back while suspended
+#if configGENERATE_RUN_TIME_STATS == (1)
+static uint32_t ulTaskSwitchedInTime = 0;               // Run time when pxCurrentTCB was switched in
+#endif
 
 // UPRTOS_OVERHEAD = sizeof(tcb_t)*4 + sizeof(uint8_t)*2 + sizeof(uint32_t) + sizeof(stack_t)*3 + sizeof(uint16_t)
 //                 = 24 bytes
@@ -139,6 +144,7 @@ TickType_t xTaskGetTickCount(void)
 {
     TickType_t xTicks;
 
+    // Also used from interrupts
     portENTER_CRITICAL();
 
     xTicks = xTickCount;
@@ -193,7 +199,7 @@ BaseType_t xTaskPlaceOnEventList(List_t * const pxEventList, const TickType_t xT
     else
     {
         // Calculate the time at which the task should be woken if the event does not occur
-        // TODO: Take care of overflow
+        // (overflow is handled by taskWAKE_TIME_REACHED)
         pxCurrentTCB->xTimeToWake = xTickCount + xTicksToWait;
         pxCurrentTCB->xState = TASK_BLOCKED;
     }
@@ -202,38 +208,80 @@ BaseType_t xTaskPlaceOnEventList(List_t * const pxEventList, const TickType_t xT
     return pdTRUE;
 }
 
+/*!
+ * @brief Make the highest priority task of an event list ready. The caller
+ *        holds the scheduler lock (vTaskSuspendAll) and its xTaskResumeAll
+ *        switches to the task when it precedes the current one.
+ */
 void vTaskYieldFromEventList(List_t * const xList)
 {
-    portENTER_CRITICAL();
+    tcb_t *pxTaskToWake = NULL;
+
+    // Event lists are only changed by tasks, so the caller's lock is enough
+    // and interrupts stay enabled during the walk
+    configASSERT(uxSchedulerSuspended != 0);
 
-    // Select the highest priority task
-    UBaseType_t xHigherPriority = configIDLE_PRIORITY;
+    // Select the highest priority task (earliest deadline on EDF)
     ListNode_t *pxNode = xList->pxHead;
-    pxAuxTCB = NULL;
     while(pxNode != NULL)
     {
         // Check if the current pending task is timeout
         tcb_t *pxTCB = ((tcb_t *)pxNode->pvItem);
         if( !osCHECK_FLAG(pxTCB->uxStatus, tskTIMEOUT_FLAG) )
         {
-            if(pxTCB->uxPriority >= xHigherPriority)
+            if(pxTaskToWake == NULL || !xTaskPrecedes(pxTaskToWake, pxTCB))
             {
-                xHigherPriority = pxTCB->uxPriority;
-                pxAuxTCB = pxTCB;
+                pxTaskToWake = pxTCB;
             }
         }
         pxNode = pxNode->pxNext;
     }
 
-    // Switch to the highest priority task
-    if(pxAuxTCB != NULL)
+    if(pxTaskToWake == NULL) return;
+
+    // Interrupts also change task states
+    taskENTER_CRITICAL();
+    pxTaskToWake->xState = TASK_READY;
+    if(xTaskPrecedes(pxTaskToWake, pxCurrentTCB)) xYieldPending = pdTRUE;
+    taskEXIT_CRITICAL();
+}
+
+void vTaskSuspendAll(void)
+{
+    // A single increment, it needs no critical section
+    ++uxSchedulerSuspended;
+}
+
+UBaseType_t xTaskResumeAll(void)
+{
+    UBaseType_t xAlreadyYielded = pdFALSE;
+
+    configASSERT_RETURN(uxSchedulerSuspended != 0, pdFALSE);
+
+    taskENTER_CRITICAL();
+
+    if( --uxSchedulerSuspended == 0 )
     {
-        // Put it in ready state and force to run (TODO is it necessary to force to run?)
-        // Or just to put in ready state
-        pxAuxTCB->xState = TASK_READY;
-        vTaskRun(pxAuxTCB);
+        // Replay the ticks counted while the scheduler was locked
+        if( xPendedTicks != 0 )
+        {
+            xTickCount += xPendedTicks;
+            xPendedTicks = 0;
+            xYieldPending = pdTRUE;
+        }
+
+        // Do the context switch the lock held back
+        if( xYieldPending )
+        {
+            xYieldPending = pdFALSE;
+            vPortTaskYield(yldSTATE_CHANGE);
+            xAlreadyYielded = pdTRUE;
+        }
     }
-    portEXIT_CRITICAL();
+
+    taskEXIT_CRITICAL();
+
+    return xAlreadyYielded;
 }
 
 
@@ -250,10 +298,24 @@ void vTaskStartScheduller(void)
         xTaskCreate(vTaskIdleHook, configMINIMAL_STACK_SIZE, NULL, configIDLE_PRIORITY, &xIdleTaskHandle);
     }
 
-    // Set scheduller task
-    xScheduleStack[1] = (StackType_t)vTaskSwitchContext;
-    xScheduleStack[0] = 0x0000;
-    pxTopOfSchStack = &xScheduleStack[0];
+    // Every task was deleted before the start
+    if(pxCurrentTCB == NULL) pxCurrentTCB = (tcb_t *)xIdleTaskHandle;
+
+#if configUSE_DEFERRED_CALLS == (1)
+    // Deferred calls daemon
+    if ( xDeferCreateDaemon() != pdTRUE)
+    {
+        while(1); // cpu trap
+    }
+#endif
+
+#if configUSE_BASIC_TASKS == (1)
+    // Basic tasks dispatcher
+    if ( xBasicCreateDispatcher() != pdTRUE)
+    {
+        while(1); // cpu trap
+    }
+#endif
 
     // Systick init
     if ( xPortSetuptTimerInterrupt() != pdTRUE)
@@ -266,7 +328,7 @@ void vTaskStartScheduller(void)
     uxSchedulerFlags |= osSCHEDULER_RUNNING;
 
     // Call task scheduler
-    portRESTORE_CONTEXT();
+    vPortStartFirstTask();
 }
 
 
@@ -277,9 +339,6 @@ UBaseType_t xTaskCreate(TaskFunction_t xTaskFunc, StackType_t uxStackDepth, void
     tcb_t *pxNewTCB = NULL;
     StackType_t *pxEndOfStack = NULL;
 
-    // To avoid compiler warnings
-    (void)pxTopOfSchStack;
-
     // Assert input arguments
 #if configUSE_PREEMPTION == (1)
     if(uxPriority > configIDLE_PRIORITY && uxCurrentNumberOfTasks >= configMAX_TASKS) return pdFALSE;
@@ -288,26 +347,44 @@ UBaseType_t xTaskCreate(TaskFunction_t xTaskFunc, StackType_t uxStackDepth, void
     if(uxStackDepth < configMINIMAL_STACK_SIZE || (uxStackDepth + sizeof(tcb_t)) > xPortGetFreeHeapSize()) return pdFALSE;
 
     // Disable interrupts
-    portENTER_CRITICAL();
+    taskENTER_CRITICAL();
 
     // Check priority
     if(uxPriority > configMAX_PRIORITIES) uxPriority = configMAX_PRIORITIES;
 
-    // Check for idle task
-    UBaseType_t uxTaskIDTmp = uxCurrentNumberOfTasks;   // save current number of tasks
+    // Check for idle task, it always takes the last ID
+    UBaseType_t uxNewId = configMAX_TASKS;
     if(uxPriority == configIDLE_PRIORITY) {
-        uxCurrentNumberOfTasks = configMAX_TASKS;
         uxSchedulerFlags |= osIDLE_TASK_SET;
     }
+    else {
+        // Take the lowest free ID, so IDs of deleted tasks are reused
+        for(uxNewId = 0; uxNewId < configMAX_TASKS; uxNewId++) {
+            if( !(uxTaskIdBitmap & (1U << uxNewId)) ) break;
+        }
+    }
 
     // Add task to scheduller
     pxNewTCB = (tcb_t *)pvPortMalloc(sizeof(tcb_t));
     if(pxNewTCB != NULL)
     {
-        pxNewTCB->uxId = uxCurrentNumberOfTasks;
+        pxNewTCB->uxId = uxNewId;
         pxNewTCB->uxStatus = 0x00;
         pxNewTCB->xState = TASK_READY;
         pxNewTCB->uxPriority = uxPriority;
+#if configUSE_EDF_SCHEDULING == (1)
+        pxNewTCB->xPeriod = 0;
+        pxNewTCB->xRelativeDeadline = 0;
+        pxNewTCB->xReleaseTime = 0;
+        pxNewTCB->xAbsoluteDeadline = 0;
+#endif
+#if ( configUSE_NOTIFICATIONS == 1 )
+        for(UBaseType_t uxIndex = 0; uxIndex < configTASK_NOTIFICATION_ARRAY_ENTRIES; uxIndex++)
+        {
+            pxNewTCB->xNotificationValue[uxIndex] = 0;
+            pxNewTCB->ucNotifyState[uxIndex] = taskNOT_WAITING_NOTIFICATION;
+        }
+#endif
 
         // Initialize task stack
 #if configSTACK_ENHANCED == (1)
@@ -323,6 +400,16 @@ UBaseType_t xTaskCreate(TaskFunction_t xTaskFunc, StackType_t uxStackDepth, void
         {
             xReturn = pdTRUE;
 
+#if configUSE_TASK_DELETE == (1) || configUSE_TRACE_FACILITY == (1)
+            pxNewTCB->pxStack = pxEndOfStack;
+#endif
+#if configUSE_TRACE_FACILITY == (1)
+            pxNewTCB->usStackDepth = uxStackDepth;
+            for(UBaseType_t uxIndex = 0; uxIndex < (uxStackDepth>>1); uxIndex++) pxEndOfStack[uxIndex] = tskSTACK_FILL_WORD;
+#endif
+#if configGENERATE_RUN_TIME_STATS == (1)
+            pxNewTCB->ulRunTimeCounter = 0;
+#endif
             pxNewTCB->pxTopOfStack = pxPortInitialiseStack(pxEndOfStack + (uxStackDepth>>1) - 1, xTaskFunc, pvParameters);
 #endif
             pxNewTCB->pxNextTCB = NULL;
@@ -330,58 +417,31 @@ UBaseType_t xTaskCreate(TaskFunction_t xTaskFunc, StackType_t uxStackDepth, void
             if(pxHandle != NULL) *pxHandle = (TaskHandle_t)pxNewTCB;
 
             // Check idle priority
-            if(uxPriority == configIDLE_PRIORITY) uxCurrentNumberOfTasks = uxTaskIDTmp;
-            else uxCurrentNumberOfTasks++;
+            if(uxPriority != configIDLE_PRIORITY)
+            {
+                uxTaskIdBitmap |= (1U << uxNewId);
+                uxCurrentNumberOfTasks++;
+            }
 
             // Add to list
             if(uxPriority != configIDLE_PRIORITY)
             {
-                if(pxTCBList == NULL)
-                {
-                    pxTCBList = pxNewTCB;
-                    pxTCBList->pxNextTCB = NULL;
-                    pxCurrentTCB = pxNewTCB;
-                }
-                else
-                {
-                    // Set current TCB as the highest priority task
-                    if(pxNewTCB->uxPriority > pxCurrentTCB->uxPriority) pxCurrentTCB = pxNewTCB;
-
-                    // Insert into the ready task list in descending order
-                    pxAuxTCB = pxTCBList;
-                    if(pxNewTCB->uxPriority >= pxTCBList->uxPriority)
-                    {
-                        pxTCBList = pxNewTCB;
-                        pxTCBList->pxNextTCB = pxAuxTCB;
-                        pxTCBList->pxNextTCB->pxNextTCB = NULL;
-                    }
-                    else
-                    {
-                        while( pxAuxTCB != NULL )
-                        {
-                            if(pxAuxTCB->pxNextTCB == NULL)
-                            {
-                                pxAuxTCB->pxNextTCB = pxNewTCB;
-                                pxAuxTCB->pxNextTCB->pxNextTCB = NULL;
-                                break;
-                            }
-                            else if(pxNewTCB->uxPriority >= pxAuxTCB->pxNextTCB->uxPriority)
-                            {
-                                //
-                                tcb_t *pxTmp = pxAuxTCB->pxNextTCB;
-                                pxAuxTCB->pxNextTCB = pxNewTCB;
-                                pxAuxTCB->pxNextTCB->pxNextTCB = pxTmp;
-                                break;
-                            }
-                            pxAuxTCB = pxAuxTCB->pxNextTCB;
-                        }
-                    }
-                }
+                // Insert into the ready task list in descending order
+                vTaskInsertTCB(pxNewTCB);
+
+                // The first task to run is the highest priority one, once
+                // started the scheduler selects it
+                if( !osCHECK_FLAG(uxSchedulerFlags, osSCHEDULER_STARTED) ) pxCurrentTCB = pxTCBList;
             }
         }
+        else
+        {
+            // Give the TCB back, the task was not created
+            vPortFree(pxNewTCB);
+        }
     }
     // Enable global interrupts if were activated
-    portEXIT_CRITICAL();
+    taskEXIT_CRITICAL();
 
     return xReturn;
 }
@@ -396,96 +456,201 @@ TaskHandle_t xTaskGetHandle(UBaseType_t uxTaskID )
 {
     TaskHandle_t xTaskHandle = NULL;
     configASSERT_RETURN(uxSchedulerFlags & osSCHEDULER_STARTED, NULL);
-    configASSERT_RETURN(uxTaskID < uxCurrentNumberOfTasks, NULL);
+    configASSERT_RETURN(uxTaskID < configMAX_TASKS, NULL);
 
-    portENTER_CRITICAL();
+    taskENTER_CRITICAL();
     pxAuxTCB = pxTCBList;
     while(pxAuxTCB != NULL)
     {
         if(pxAuxTCB->uxId == uxTaskID)
         {
-            xTaskHandle = (TaskHandle_t)pxCurrentTCB;
+            xTaskHandle = (TaskHandle_t)pxAuxTCB;
             break;
         }
+        pxAuxTCB = pxAuxTCB->pxNextTCB;
     }
-    portEXIT_CRITICAL();
+    taskEXIT_CRITICAL();
 
     return xTaskHandle;
 }
 
+#if configUSE_TRACE_FACILITY == (1)
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    // Application tasks plus the idle task
+    return uxCurrentNumberOfTasks + ((xIdleTaskHandle != NULL) ? 1 : 0);
+}
+
+/*!
+ * @name uxTaskGetSystemState
+ * @brief Take a snapshot of every task, the idle task is the last entry.
+ *        Interrupts stay enabled, only the scheduler is suspended while the
+ *        stacks are scanned for their high-water mark.
+ * @param pxTaskStatusArray Array to fill
+ * @param uxArraySize Entries in pxTaskStatusArray, at least uxTaskGetNumberOfTasks()
+ * @param pulTotalRunTime Total run time (can be NULL), 0 without configGENERATE_RUN_TIME_STATS
+ * @return Number of entries filled, 0 if the array is too small
+ */
+UBaseType_t uxTaskGetSystemState(   TaskStatus_t * const pxTaskStatusArray,
+                                    const UBaseType_t uxArraySize,
+                                    uint32_t * const pulTotalRunTime )
+{
+    UBaseType_t uxTask = 0;
+    tcb_t *pxTCB;
+
+    configASSERT_RETURN(pxTaskStatusArray != NULL, 0);
+
+    vTaskSuspendAll();
+
+    if(uxArraySize >= uxTaskGetNumberOfTasks())
+    {
+        for(pxTCB = pxTCBList; pxTCB != NULL; pxTCB = pxTCB->pxNextTCB)
+        {
+            vTaskGetStatus(pxTCB, &pxTaskStatusArray[uxTask++]);
+        }
+        if(xIdleTaskHandle != NULL)
+        {
+            vTaskGetStatus((tcb_t *)xIdleTaskHandle, &pxTaskStatusArray[uxTask++]);
+        }
+
+        if(pulTotalRunTime != NULL)
+        {
+#if configGENERATE_RUN_TIME_STATS == (1)
+            *pulTotalRunTime = portGET_RUN_TIME_COUNTER_VALUE();
+#else
+            *pulTotalRunTime = 0;
+#endif
+        }
+    }
+
+    (void)xTaskResumeAll();
+
+    return uxTask;
+}
+#endif
+
 TaskHandle_t xTaskGetCurrentTaskHandle(void)
 {
     TaskHandle_t xCurrentTaskHandle = NULL;
     configASSERT_RETURN(osCHECK_FLAG(uxSchedulerFlags,osSCHEDULER_STARTED), NULL);
 
-    portENTER_CRITICAL();
+    taskENTER_CRITICAL();
     xCurrentTaskHandle = (TaskHandle_t)pxCurrentTCB;
-    portEXIT_CRITICAL();
+    taskEXIT_CRITICAL();
 
     return xCurrentTaskHandle;
 }
 
 void vTaskDelay(const TickType_t xTicksToDelay)
 {
-    // The sr needs saving before it is modified.
-    portSAVE_CPU_STATUS();
+    // Disable interrupts
+    taskENTER_CRITICAL();
+
+    vTaskSetTimeToWake(xTicksToDelay);
+
+    // Call scheduller
+    traceMASK_YIELD_BEGIN();
+    vPortYield();
+    traceMASK_YIELD_END();
+
+    // The delay always ends by timeout
+    (void)xTaskCheckTimeout();
+
+    taskEXIT_CRITICAL();
+}
+
+void vTaskDelayUntil(TickType_t * const pxPreviousWakeTime, const TickType_t xTimeIncrement)
+{
+    configASSERT(pxPreviousWakeTime != NULL);
+    configASSERT(xTimeIncrement > 0 && xTimeIncrement <= (portMAX_DELAY >> 1));
 
     // Disable interrupts
-    portDISABLE_INTERRUPTS();
+    taskENTER_CRITICAL();
 
-    // Save context
-    portSAVE_CONTEXT();
+    // Next release is relative to the previous one, not to the current tick,
+    // so the time spent by the task body does not accumulate
+    TickType_t xTimeToWake = *pxPreviousWakeTime + xTimeIncrement;
+    TickType_t xTimeElapsed = xTickCount - *pxPreviousWakeTime;
+    *pxPreviousWakeTime = xTimeToWake;
 
-    //
-    if( xTicksToDelay == portMAX_DELAY )
+    // A task that overran its period is not blocked
+    if( xTimeElapsed < xTimeIncrement )
     {
-        //
-        pxCurrentTCB->xState = TASK_SUSPENDED;
-    }
-    else
-    {
-        // Calculate the time at which the task should be woken if the event does not occur
-        // TODO: Take care of overflow
-        pxCurrentTCB->xTimeToWake = xTickCount + xTicksToDelay;
+        pxCurrentTCB->xTimeToWake = xTimeToWake;
         pxCurrentTCB->xState = TASK_BLOCKED;
+
+        // Task yield
+        vPortTaskYield(yldSTATE_UNCHANGE);
+
+        // Waking up on time is not a timeout
+        (void)xTaskCheckTimeout();
     }
 
-    // Call scheduller
-    vTaskSwitchContext();
+    taskEXIT_CRITICAL();
 }
 
 
-void vPortTaskYield(UBaseType_t xYieldFlags)
+#if configUSE_EDF_SCHEDULING == (1)
+UBaseType_t xTaskSetTimingConstraints(TaskHandle_t xTask, const TickType_t xPeriod, const TickType_t xRelativeDeadline)
 {
-    // The sr needs saving before it is modified.
-    portSAVE_CPU_STATUS();
+    tcb_t *pxTCB = (xTask != NULL) ? (tcb_t *)xTask : pxCurrentTCB;
 
-    // Disable interrupts
-    portDISABLE_INTERRUPTS();
+    configASSERT_RETURN(pxTCB != NULL, pdFALSE);
+    configASSERT_RETURN(xPeriod <= (portMAX_DELAY >> 1) && xRelativeDeadline <= (portMAX_DELAY >> 1), pdFALSE);
 
-    // Save context
-    portSAVE_CONTEXT();
+    taskENTER_CRITICAL();
+
+    // The first job is released now
+    pxTCB->xPeriod = xPeriod;
+    pxTCB->xRelativeDeadline = xRelativeDeadline;
+    pxTCB->xReleaseTime = xTickCount;
+    pxTCB->xAbsoluteDeadline = pxTCB->xReleaseTime + xRelativeDeadline;
+
+    taskEXIT_CRITICAL();
+
+    return pdTRUE;
+}
+
+void vTaskWaitForNextPeriod(void)
+{
+    configASSERT(pxCurrentTCB->xPeriod != 0);
+
+    // Deadline of the next job, it only matters once the task is ready again
+    taskENTER_CRITICAL();
+    pxCurrentTCB->xAbsoluteDeadline = pxCurrentTCB->xReleaseTime + pxCurrentTCB->xPeriod + pxCurrentTCB->xRelativeDeadline;
+    taskEXIT_CRITICAL();
+
+    vTaskDelayUntil(&pxCurrentTCB->xReleaseTime, pxCurrentTCB->xPeriod);
+}
+#endif
+
+
+void vPortTaskYield(UBaseType_t xYieldFlags)
+{
+    // Disable interrupts
+    taskENTER_CRITICAL();
 
     //
     if( osCHECK_FLAG(xYieldFlags,yldSTATE_CHANGE) ) pxCurrentTCB->xState = TASK_READY;
 
     // Call scheduller
-    vTaskSwitchContext();
+    traceMASK_YIELD_BEGIN();
+    vPortYield();
+    traceMASK_YIELD_END();
+
+    taskEXIT_CRITICAL();
 }
 
 void vTaskSuspend(TaskHandle_t xTaskToSuspend)
 {
-    // The sr needs saving before it is modified.
-    portSAVE_CPU_STATUS();
-
     // Critical section begins
-    portENTER_CRITICAL();
+    taskENTER_CRITICAL();
 
     if(xTaskToSuspend != NULL)
     {
         if( ((tcb_t *)xTaskToSuspend)->xState != TASK_SUSPENDED )
         {
-            if( ((tcb_t *)xTaskToSuspend)->uxId < uxCurrentNumberOfTasks )
+            if( ((tcb_t *)xTaskToSuspend)->uxId < configMAX_TASKS )
             {
                 ((tcb_t *)xTaskToSuspend)->xState = TASK_SUSPENDED;
             }
@@ -496,10 +661,7 @@ void vTaskSuspend(TaskHandle_t xTaskToSuspend)
     }
 
     // Critical section ends
-    portEXIT_CRITICAL();
-
-    // Restore status register
-    portRESTORE_CPU_STATUS();
+    taskEXIT_CRITICAL();
 }
 
 void vTaskResume(TaskHandle_t xTaskToResume)
@@ -507,13 +669,13 @@ void vTaskResume(TaskHandle_t xTaskToResume)
     configASSERT(xTaskToResume != NULL);
     configASSERT(((tcb_t *)xTaskToResume)->uxId != pxCurrentTCB->uxId);
 
-    portENTER_CRITICAL();
+    taskENTER_CRITICAL();
 
-    if( ((tcb_t *)xTaskToResume)->uxId < uxCurrentNumberOfTasks)
+    if( ((tcb_t *)xTaskToResume)->uxId < configMAX_TASKS)
     {
         if(((tcb_t *)xTaskToResume)->xState == TASK_SUSPENDED)
         {
-            if(((tcb_t *)xTaskToResume)->uxPriority > pxCurrentTCB->uxPriority)
+            if(xTaskPrecedes((tcb_t *)xTaskToResume, pxCurrentTCB))
             {
                 // Yield
                 vTaskRun((tcb_t *)xTaskToResume);
@@ -525,19 +687,119 @@ void vTaskResume(TaskHandle_t xTaskToResume)
         }
     }
 
-    portEXIT_CRITICAL();
+    taskEXIT_CRITICAL();
 }
 
+UBaseType_t uxTaskPriorityGet(const TaskHandle_t xTask)
+{
+    const tcb_t *pxTCB = (xTask != NULL) ? (const tcb_t *)xTask : pxCurrentTCB;
+
+    configASSERT_RETURN(pxTCB != NULL, configIDLE_PRIORITY);
+
+    // A single word read, it needs no critical section
+    return pxTCB->uxPriority;
+}
 
-inline void vPortSaveContextFromISR(void)
+/*!
+ * @name vTaskPrioritySet
+ * @brief Change the priority of a task (NULL for the calling task). A
+ *        context switch is done if the change makes another task run first.
+ * @note  O(n) in the number of tasks, not O(1): the task is unlinked from
+ *        pxTCBList and inserted again to keep it sorted, two walks of at
+ *        most configMAX_TASKS nodes. There are no per-priority ready lists,
+ *        vTaskSwitchContext scans the whole list on every switch anyway.
+ */
+void vTaskPrioritySet(TaskHandle_t xTask, UBaseType_t uxNewPriority)
 {
-    portSAVE_CONTEXT_FROM_ISR();
+    tcb_t *pxTCB = (xTask != NULL) ? (tcb_t *)xTask : pxCurrentTCB;
+
+    configASSERT(pxTCB != NULL);
+    configASSERT(pxTCB != (tcb_t *)xIdleTaskHandle);        // Idle task is not in pxTCBList
+    configASSERT(uxNewPriority > configIDLE_PRIORITY);      // Only the idle task runs at idle priority
+    configASSERT(pxTCB->uxId < configMAX_TASKS && pxTCB->xState != TASK_DELETED);
+
+    // Check priority
+    if(uxNewPriority > configMAX_PRIORITIES) uxNewPriority = configMAX_PRIORITIES;
+
+    // Critical section begins
+    taskENTER_CRITICAL();
+
+    if(pxTCB->uxPriority != uxNewPriority)
+    {
+        UBaseType_t xLowered = (uxNewPriority < pxTCB->uxPriority);
+
+        // Requeue
+        vTaskUnlinkTCB(pxTCB);
+        pxTCB->uxPriority = uxNewPriority;
+        vTaskInsertTCB(pxTCB);
+
+        if( !osCHECK_FLAG(uxSchedulerFlags, osSCHEDULER_STARTED) )
+        {
+            pxCurrentTCB = pxTCBList;
+        }
+        else if(pxTCB == pxCurrentTCB)
+        {
+            // A lowered task lets the scheduler look for a higher one
+            if(xLowered) vPortTaskYield(yldSTATE_CHANGE);
+        }
+        else if(pxTCB->xState == TASK_READY && xTaskPrecedes(pxTCB, pxCurrentTCB))
+        {
+            // Yield
+            vTaskRun(pxTCB);
+        }
+    }
+
+    // Critical section ends
+    taskEXIT_CRITICAL();
 }
 
-inline void vPortRestoreContextFromISR(void)
+#if configUSE_TASK_DELETE == (1)
+void vTaskDelete(TaskHandle_t xTaskToDelete)
 {
-    portRESTORE_CONTEXT();
+    tcb_t *pxTCB = (xTaskToDelete != NULL) ? (tcb_t *)xTaskToDelete : pxCurrentTCB;
+
+    configASSERT(pxTCB != NULL);
+    configASSERT(pxTCB != (tcb_t *)xIdleTaskHandle);                // Idle task cannot be deleted
+    configASSERT(pxTCB->uxId < configMAX_TASKS && pxTCB->xState != TASK_DELETED);
+
+    // Critical section begins
+    taskENTER_CRITICAL();
+
+    // Remove it from the scheduler and from any queue/mutex pending list
+    vTaskUnlinkTCB(pxTCB);
+    if(pxTCB->xEventListItem.pvContainer != NULL)
+    {
+        vListRemove((List_t *)pxTCB->xEventListItem.pvContainer, &pxTCB->xEventListItem);
+    }
+
+    // Release its ID
+    uxTaskIdBitmap &= ~(1U << pxTCB->uxId);
+    uxCurrentNumberOfTasks--;
+    pxTCB->xState = TASK_DELETED;
+
+    if( !osCHECK_FLAG(uxSchedulerFlags, osSCHEDULER_STARTED) )
+    {
+        // No task runs yet (vTaskDelete(NULL) from main), pxCurrentTCB is
+        // only the first task to start
+        pxCurrentTCB = pxTCBList;
+    }
+    else if(pxTCB == pxCurrentTCB)
+    {
+        // The task is still running on its own stack, so the idle task frees it
+        pxTCB->pxNextTCB = pxTasksWaitingTermination;
+        pxTasksWaitingTermination = pxTCB;
+
+        // Never returns
+        vPortTaskYield(yldSTATE_UNCHANGE);
+    }
+
+    // Other tasks are not using their stack, free it right now
+    vTaskFreeTCB(pxTCB);
+
+    // Critical section ends
+    taskEXIT_CRITICAL();
 }
+#endif
 
 
 
@@ -548,6 +810,10 @@ void vTaskIdleHook(void *pvParams)
     asm(" mov #1023,R15\n"); // For debug
     while(1)
     {
+#if configUSE_TASK_DELETE == (1)
+        // Give back the memory of the tasks that deleted themselves
+        vTaskCheckTasksWaitingTermination();
+#endif
         __no_operation();
     }
 }
@@ -558,94 +824,137 @@ void vTaskIdleHook(void *pvParams)
 
 
 
-UBaseType_t xTaskNotifyWait( uint16_t uxBitsToClear,
-                             uint16_t *pxNotificationValue,
-                           TickType_t xTicksToWait )
+#if ( configUSE_NOTIFICATIONS == 1 )
+UBaseType_t xTaskNotifyWaitIndexed( UBaseType_t uxIndexToWaitOn,
+                                    uint16_t uxBitsToClear,
+                                    uint16_t *pxNotificationValue,
+                                    TickType_t xTicksToWait )
 {
-    // The sr needs saving before it is modified.
-    portSAVE_CPU_STATUS();
+    configASSERT_RETURN(uxIndexToWaitOn < configTASK_NOTIFICATION_ARRAY_ENTRIES, pdFALSE);
 
-    UBaseType_t xReturn = pdTRUE;
+    UBaseType_t xReturn = pdFALSE;
 
     // Disable interrupts
-    portDISABLE_INTERRUPTS();
-
-    // Clear notification values
-    pxCurrentTCB->xNotificationValue &= ~uxBitsToClear;
+    taskENTER_CRITICAL();
 
-    // Suspend task
-    if( xTicksToWait == portMAX_DELAY )
+    // Only block if no notification is already pending
+    if( pxCurrentTCB->ucNotifyState[uxIndexToWaitOn] != taskNOTIFICATION_RECEIVED && xTicksToWait )
     {
-        //
-        pxCurrentTCB->xState = TASK_SUSPENDED;
+        // Clear notification values
+        pxCurrentTCB->xNotificationValue[uxIndexToWaitOn] &= ~uxBitsToClear;
+        pxCurrentTCB->ucNotifyState[uxIndexToWaitOn] = taskWAITING_NOTIFICATION;
+
+        // Suspend task
+        vTaskSetTimeToWake(xTicksToWait);
+
+        // Task yield
+        vPortTaskYield(yldSTATE_UNCHANGE);
+
+        // Clear the timeout flag, the notify state tells whether the task was notified
+        (void)xTaskCheckTimeout();
     }
-    else
+
+    // Consume the notification
+    if( pxCurrentTCB->ucNotifyState[uxIndexToWaitOn] == taskNOTIFICATION_RECEIVED )
     {
-        // Calculate the time at which the task should be woken if the event does not occur
-        // TODO: Take care of overflow
-        pxCurrentTCB->xTimeToWake = xTickCount + xTicksToWait;
-        pxCurrentTCB->xState = TASK_BLOCKED;
+        if(pxNotificationValue != NULL) *pxNotificationValue = pxCurrentTCB->xNotificationValue[uxIndexToWaitOn];
+        xReturn = pdTRUE;
     }
+    pxCurrentTCB->ucNotifyState[uxIndexToWaitOn] = taskNOT_WAITING_NOTIFICATION;
 
-    // Task yield
-    vPortTaskYield(0);
+    taskEXIT_CRITICAL();
 
-    // Check for timeout
-    //if(!(pxCurrentTCB->uxStatus & tskMAX_DELAY_FLAG) && xTickCount >= pxCurrentTCB->xTimeToWake) xReturn = pdFALSE;
-    if( xTaskCheckTimeout() ) xReturn = pdFALSE;
-    else *pxNotificationValue = pxCurrentTCB->xNotificationValue;
+    return xReturn;
+}
 
-    // Restore previous SR
-    portRESTORE_CPU_STATUS();
 
-    return xReturn;
+uint16_t usTaskNotifyTakeIndexed( UBaseType_t uxIndexToWaitOn,
+                                  UBaseType_t xClearCountOnExit,
+                                  TickType_t xTicksToWait )
+{
+    configASSERT_RETURN(uxIndexToWaitOn < configTASK_NOTIFICATION_ARRAY_ENTRIES, 0);
 
+    uint16_t usReturn;
+
+    // Disable interrupts
+    taskENTER_CRITICAL();
+
+    // Only block if the count is zero
+    if( pxCurrentTCB->xNotificationValue[uxIndexToWaitOn] == 0 && xTicksToWait )
+    {
+        pxCurrentTCB->ucNotifyState[uxIndexToWaitOn] = taskWAITING_NOTIFICATION;
+
+        // Suspend task
+        vTaskSetTimeToWake(xTicksToWait);
+
+        // Task yield
+        vPortTaskYield(yldSTATE_UNCHANGE);
+
+        // Clear the timeout flag, a zero count means timeout
+        (void)xTaskCheckTimeout();
+    }
+
+    // Take from the count
+    usReturn = pxCurrentTCB->xNotificationValue[uxIndexToWaitOn];
+    if( usReturn )
+    {
+        if( xClearCountOnExit ) pxCurrentTCB->xNotificationValue[uxIndexToWaitOn] = 0;
+        else pxCurrentTCB->xNotificationValue[uxIndexToWaitOn]--;
+    }
+    pxCurrentTCB->ucNotifyState[uxIndexToWaitOn] = taskNOT_WAITING_NOTIFICATION;
+
+    taskEXIT_CRITICAL();
+
+    return usReturn;
 }
 
 
-UBaseType_t xTaskNotify( TaskHandle_t xTaskToNotify,
-                         uint16_t xValue,
-                         eNotifyAction eAction)
+UBaseType_t xTaskNotifyIndexed( TaskHandle_t xTaskToNotify,
+                                UBaseType_t uxIndexToNotify,
+                                uint16_t xValue,
+                                eNotifyAction eAction)
 {
+    UBaseType_t xReturn = pdTRUE;
+    tcb_t *pxTCB = (tcb_t *)xTaskToNotify;
+
     // Assertions
-    configASSERT_RETURN(xTaskToNotify != NULL, pdFALSE);                                    // Task to notify must not be NULL
-    configASSERT_RETURN(((tcb_t *)xTaskToNotify)->uxId < uxCurrentNumberOfTasks, pdFALSE);  // Task to notify must have a valid ID
-    configASSERT_RETURN(((tcb_t *)xTaskToNotify)->uxId != pxCurrentTCB->uxId, pdFALSE);     // Task to notify must not be the running task
-    configASSERT_RETURN(((tcb_t *)xTaskToNotify)->xState == TASK_BLOCKED, pdFALSE);         // Task to notify should be in the blocked state
+    configASSERT_RETURN(pxTCB != NULL, pdFALSE);                                            // Task to notify must not be NULL
+    configASSERT_RETURN(pxTCB->uxId < configMAX_TASKS, pdFALSE);                            // Task to notify must have a valid ID
+    configASSERT_RETURN(uxIndexToNotify < configTASK_NOTIFICATION_ARRAY_ENTRIES, pdFALSE);  // Index must be within the notification array
 
     // Disable interrupts
-    portENTER_CRITICAL();
+    taskENTER_CRITICAL();
 
     // Notify
-    switch(eAction)
+    uint8_t ucOriginalState = ucTaskNotifyUpdate(pxTCB, uxIndexToNotify, xValue, eAction);
+    if( eAction == eSetValueWithoutOverwrite && ucOriginalState == taskNOTIFICATION_RECEIVED )
     {
-        case eSetBits:
-            ((tcb_t *)xTaskToNotify)->xNotificationValue |= xValue;
-        break;
-
-        case eIncrement:
-            ((tcb_t *)xTaskToNotify)->xNotificationValue++;
-        break;
-
-        case eSetValueWithOverwrite:
-            ((tcb_t *)xTaskToNotify)->xNotificationValue = xValue;
-        break;
-
-        default:
-        break;
+        xReturn = pdFALSE;
     }
 
-    // Put in ready state
-    ((tcb_t *)xTaskToNotify)->xState = TASK_READY;
+    // Wake the task up only if it was waiting for this notification, otherwise it is left pending
+    if( ucOriginalState == taskWAITING_NOTIFICATION )
+    {
+        if( xTaskPrecedes(pxTCB, pxCurrentTCB) )
+        {
+            // Yield
+            vTaskRun(pxTCB);
+        }
+        else
+        {
+            pxTCB->xState = TASK_READY;
+        }
+    }
 
     // Enable interrupts
-    portEXIT_CRITICAL();
+    taskEXIT_CRITICAL();
 
-    return pdTRUE;
+    return xReturn;
 }
 
 
-void vTaskNotifyFromISR( TaskHandle_t xTaskToNotify,
+void vTaskNotifyIndexedFromISR( TaskHandle_t xTaskToNotify,
+                                UBaseType_t uxIndexToNotify,
                                 uint16_t xValue,
                                 eNotifyAction eAction,
                                 UBaseType_t *pxHigherPriorityTaskWoken )
@@ -655,43 +964,23 @@ void vTaskNotifyFromISR( TaskHandle_t xTaskToNotify,
 
     // Assertions
     configASSERT(xTaskToNotify != NULL);
-    configASSERT(pxAuxTCB->xState == TASK_BLOCKED);
-    configASSERT(pxAuxTCB->uxId < uxCurrentNumberOfTasks);
-    configASSERT(pxAuxTCB->uxId != pxCurrentTCB->uxId);
+    configASSERT(pxAuxTCB->uxId < configMAX_TASKS);
+    configASSERT(uxIndexToNotify < configTASK_NOTIFICATION_ARRAY_ENTRIES);
 
-    // Notify
-    switch(eAction)
-    {
-        case eSetBits:
-            pxAuxTCB->xNotificationValue |= xValue;
-        break;
-
-        case eIncrement:
-            pxAuxTCB->xNotificationValue++;
-        break;
-
-        case eSetValueWithOverwrite:
-            pxAuxTCB->xNotificationValue = xValue;
-        break;
-
-        default:
-        break;
-    }
+    // Notify, a task that is not waiting keeps the notification pending
+    if( ucTaskNotifyUpdate(pxAuxTCB, uxIndexToNotify, xValue, eAction) != taskWAITING_NOTIFICATION ) return;
 
     pxAuxTCB->xState = TASK_READY;
-    if( pxAuxTCB->uxPriority >= pxCurrentTCB->uxPriority )
-    {
-        // Suspend current task
-        pxCurrentTCB->xState = TASK_READY;
-
-        // Change current task to the task to notify
-        pxCurrentTCB = pxAuxTCB;
-        pxCurrentTCB->xState = TASK_RUNNING;
 
+    // The caller switches with portYIELD_FROM_ISR(), otherwise the task
+    // runs on the next scheduler call
+    if( pxHigherPriorityTaskWoken != NULL && xTaskPrecedes(pxAuxTCB, pxCurrentTCB) )
+    {
         // Set true
         *pxHigherPriorityTaskWoken = pdTRUE;
     }
 }
+#endif /* configUSE_NOTIFICATIONS */
 
 
 
@@ -704,24 +993,78 @@ void vTaskNotifyFromISR( TaskHandle_t xTaskToNotify,
 
 
 
-/* Private reference functions -----------------------------------*/
+/*!
+ * @name vTaskIncrementTick
+ * @brief Called from the Systick interrupt, after the interrupted task was saved
+ */
+void vTaskIncrementTick(void)
+{
+    // Keep the tick for xTaskResumeAll
+    if(uxSchedulerSuspended)
+    {
+        ++xPendedTicks;
+        return;
+    }
+
+    // Increment systick
+    ++xTickCount;
+}
+
+/*!
+ * @name vTaskSwitchContext
+ * @brief Select the task to run in pxCurrentTCB, called from UpPortable.asm
+ *        once the current task is saved
+ */
 void vTaskSwitchContext(void)
 {
+    traceMASK_SWITCH();
+
+    // The scheduler is locked, keep the current task until xTaskResumeAll
+    if(uxSchedulerSuspended)
+    {
+        xYieldPending = pdTRUE;
+        pxCurrentTCB->xState = TASK_RUNNING;
+        return;
+    }
+
+    // The outgoing task competes again, on a tick or on a yield alone
+    if(pxCurrentTCB->xState == TASK_RUNNING) pxCurrentTCB->xState = TASK_READY;
+
+#if configGENERATE_RUN_TIME_STATS == (1)
+    // Charge the outgoing task, while the scheduler is suspended it keeps accumulating
+    uint32_t ulNow = portGET_RUN_TIME_COUNTER_VALUE();
+    pxCurrentTCB->ulRunTimeCounter += ulNow - ulTaskSwitchedInTime;
+    ulTaskSwitchedInTime = ulNow;
+#endif
+
+    // Direct switch requested by vTaskRun
+    if(pxTaskToRunNext != NULL)
+    {
+        pxCurrentTCB = pxTaskToRunNext;
+        pxTaskToRunNext = NULL;
+        pxCurrentTCB->xState = TASK_RUNNING;
+        return;
+    }
+
     // Suspend current task
 #if configUSE_PREEMPTION == (1)
     pxAuxTCB = pxTCBList;
+#if configUSE_EDF_SCHEDULING == (1)
+    tcb_t *pxSelectedTCB = (pxCurrentTCB->xState == TASK_READY) ? pxCurrentTCB : NULL;
+#else
     UBaseType_t xHighestPriority = pxCurrentTCB->uxPriority;
     if(pxCurrentTCB->xState != TASK_READY)
     {
         xHighestPriority = configIDLE_PRIORITY;
     }
+#endif
 
     while(pxAuxTCB != NULL)
     {
         // Check timeout
         if(pxAuxTCB->xState == TASK_BLOCKED)
         {
-            if(xTickCount >= pxAuxTCB->xTimeToWake)
+            if(taskWAKE_TIME_REACHED(pxAuxTCB->xTimeToWake))
             {
                 pxAuxTCB->uxStatus |= tskTIMEOUT_FLAG;
                 pxAuxTCB->xState = TASK_READY;
@@ -731,14 +1074,24 @@ void vTaskSwitchContext(void)
         // Check priority for ready tasks
         if(pxAuxTCB->xState == TASK_READY)
         {
+#if configUSE_EDF_SCHEDULING == (1)
+            if(pxSelectedTCB == NULL || xTaskPrecedes(pxAuxTCB, pxSelectedTCB))
+            {
+                pxSelectedTCB = pxAuxTCB;
+            }
+#else
             if(pxAuxTCB->uxPriority > xHighestPriority)
             {
                 pxCurrentTCB = pxAuxTCB;
                 xHighestPriority = pxCurrentTCB->uxPriority;
             }
+#endif
         }
         pxAuxTCB = pxAuxTCB->pxNextTCB;
     }
+#if configUSE_EDF_SCHEDULING == (1)
+    if(pxSelectedTCB != NULL) pxCurrentTCB = pxSelectedTCB;
+#endif
 #else
     uint8_t xPass = 0;
     do
@@ -746,7 +1099,7 @@ void vTaskSwitchContext(void)
         pxCurrentTCB = pxCurrentTCB->pxNextTCB;
         // Check for delayed
         if(pxCurrentTCB->xState == TASK_DELAYED) {
-            if(xTickCount >= pxCurrentTCB->xTimeToWake) {
+            if(taskWAKE_TIME_REACHED(pxCurrentTCB->xTimeToWake)) {
                 pxCurrentTCB->xState = TASK_READY;
                 break;
             }
@@ -760,43 +1113,191 @@ void vTaskSwitchContext(void)
         pxCurrentTCB = (tcb_t *)xIdleTaskHandle;
     }
     pxCurrentTCB->xState = TASK_RUNNING;
+}
+
 
-    //!< New implementation
-    portRESTORE_CONTEXT();
+/* Private reference functions -----------------------------------*/
+
+static void vTaskSetTimeToWake(const TickType_t xTicksToWait)
+{
+    if( xTicksToWait == portMAX_DELAY )
+    {
+        //
+        pxCurrentTCB->xState = TASK_SUSPENDED;
+    }
+    else
+    {
+        // Calculate the time at which the task should be woken if the event does not occur
+        // (overflow is handled by taskWAKE_TIME_REACHED)
+        pxCurrentTCB->xTimeToWake = xTickCount + xTicksToWait;
+        pxCurrentTCB->xState = TASK_BLOCKED;
+    }
 }
 
-static void vTaskRun(tcb_t *pxTaskToRun)
+/*!
+ * @brief Check if pxTCB must run before pxOtherTCB. The priority decides
+ *        first, so the daemons and high priority tasks are never starved.
+ *        On EDF, within a priority a task with a deadline runs before one
+ *        without it and the earliest absolute deadline wins.
+ */
+static UBaseType_t xTaskPrecedes(const tcb_t *pxTCB, const tcb_t *pxOtherTCB)
 {
-    // The sr needs saving before it is modified.
-    portSAVE_CPU_STATUS();
+    if(pxTCB->uxPriority != pxOtherTCB->uxPriority)
+    {
+        return (pxTCB->uxPriority > pxOtherTCB->uxPriority);
+    }
 
-    portSAVE_CONTEXT();
-    pxCurrentTCB->xState = TASK_READY;
+#if configUSE_EDF_SCHEDULING == (1)
+    if(pxTCB->xRelativeDeadline != 0 && pxOtherTCB->xRelativeDeadline != 0)
+    {
+        // Earlier deadline (wrap safe)
+        return ( (TickType_t)(pxTCB->xAbsoluteDeadline - pxOtherTCB->xAbsoluteDeadline) > (portMAX_DELAY >> 1) );
+    }
 
-    // Switch task
-    pxCurrentTCB = pxTaskToRun;
-    pxCurrentTCB->xState = TASK_RUNNING;
-    portRESTORE_CONTEXT();
+    // Only one of them has a deadline
+    return (pxTCB->xRelativeDeadline != 0 && pxOtherTCB->xRelativeDeadline == 0);
+#else
+    return pdFALSE;
+#endif
 }
 
+#if ( configUSE_NOTIFICATIONS == 1 )
+static uint8_t ucTaskNotifyUpdate(tcb_t *pxTCB, UBaseType_t uxIndexToNotify, uint16_t xValue, eNotifyAction eAction)
+{
+    uint8_t ucOriginalState = pxTCB->ucNotifyState[uxIndexToNotify];
+
+    switch(eAction)
+    {
+        case eSetBits:
+            pxTCB->xNotificationValue[uxIndexToNotify] |= xValue;
+        break;
+
+        case eIncrement:
+            pxTCB->xNotificationValue[uxIndexToNotify]++;
+        break;
 
+        case eSetValueWithOverwrite:
+            pxTCB->xNotificationValue[uxIndexToNotify] = xValue;
+        break;
 
+        case eSetValueWithoutOverwrite:
+            if(ucOriginalState != taskNOTIFICATION_RECEIVED) pxTCB->xNotificationValue[uxIndexToNotify] = xValue;
+        break;
 
+        default:
+        break;
+    }
 
+    // Mark as pending until the task consumes it
+    pxTCB->ucNotifyState[uxIndexToNotify] = taskNOTIFICATION_RECEIVED;
 
-/* Interrupt handler ------------------------------*/
-#pragma vector = TIMER1_A0_VECTOR
-__interrupt void Systick_IRQHandler(void)
+    return ucOriginalState;
+}
+#endif
+
+#if configUSE_TRACE_FACILITY == (1)
+static void vTaskGetStatus(const tcb_t *pxTCB, TaskStatus_t *pxTaskStatus)
+{
+    const StackType_t *pxStackWord = pxTCB->pxStack;
+    const StackType_t *pxStackLimit = pxTCB->pxStack + (pxTCB->usStackDepth >> 1);
+
+    pxTaskStatus->xHandle = (TaskHandle_t)pxTCB;
+    pxTaskStatus->uxId = pxTCB->uxId;
+    pxTaskStatus->uxPriority = pxTCB->uxPriority;
+    pxTaskStatus->eCurrentState = pxTCB->xState;
+    pxTaskStatus->xTimeToWake = pxTCB->xTimeToWake;
+
+    // The stack grows down, count the words never written from its end
+    while(pxStackWord < pxStackLimit && *pxStackWord == tskSTACK_FILL_WORD) pxStackWord++;
+    pxTaskStatus->usStackHighWaterMark = (uint16_t)(pxStackWord - pxTCB->pxStack) << 1;
+
+#if configGENERATE_RUN_TIME_STATS == (1)
+    // Updated by the Systick, read it with interrupts disabled
+    taskENTER_CRITICAL();
+    pxTaskStatus->ulRunTimeCounter = pxTCB->ulRunTimeCounter;
+    taskEXIT_CRITICAL();
+#endif
+}
+#endif
+
+static void vTaskInsertTCB(tcb_t *pxTCB)
 {
-    // Save current context
-    asm(" pop R15\n");  // Seems like R15 is always pushed onto the stack on every interrupt
-                        // This is because of xTickCount or pxCurrentTCB or call to scheduler
-    portSAVE_CONTEXT();
+    tcb_t *pxPreviousTCB;
+
+    // Descending priority, a task goes before the others of its priority
+    if(pxTCBList == NULL || pxTCB->uxPriority >= pxTCBList->uxPriority)
+    {
+        pxTCB->pxNextTCB = pxTCBList;
+        pxTCBList = pxTCB;
+    }
+    else
+    {
+        pxPreviousTCB = pxTCBList;
+        while(pxPreviousTCB->pxNextTCB != NULL && pxTCB->uxPriority < pxPreviousTCB->pxNextTCB->uxPriority)
+        {
+            pxPreviousTCB = pxPreviousTCB->pxNextTCB;
+        }
+        pxTCB->pxNextTCB = pxPreviousTCB->pxNextTCB;
+        pxPreviousTCB->pxNextTCB = pxTCB;
+    }
+}
+
+static void vTaskUnlinkTCB(tcb_t *pxTCB)
+{
+    if(pxTCBList == pxTCB)
+    {
+        pxTCBList = pxTCB->pxNextTCB;
+    }
+    else
+    {
+        pxAuxTCB = pxTCBList;
+        while(pxAuxTCB != NULL)
+        {
+            if(pxAuxTCB->pxNextTCB == pxTCB)
+            {
+                pxAuxTCB->pxNextTCB = pxTCB->pxNextTCB;
+                break;
+            }
+            pxAuxTCB = pxAuxTCB->pxNextTCB;
+        }
+    }
+    pxTCB->pxNextTCB = NULL;
+}
+
+#if configUSE_TASK_DELETE == (1)
+static void vTaskFreeTCB(tcb_t *pxTCB)
+{
+    vPortFree(pxTCB->pxStack);
+    vPortFree(pxTCB);
+}
+
+static void vTaskCheckTasksWaitingTermination(void)
+{
+    tcb_t *pxTCB;
+
+    while(pxTasksWaitingTermination != NULL)
+    {
+        taskENTER_CRITICAL();
+        pxTCB = pxTasksWaitingTermination;
+        pxTasksWaitingTermination = pxTCB->pxNextTCB;
+        taskEXIT_CRITICAL();
+
+        vTaskFreeTCB(pxTCB);
+    }
+}
+#endif
+
+static void vTaskRun(tcb_t *pxTaskToRun)
+{
+    taskENTER_CRITICAL();
 
-    // Increment systick
-    ++xTickCount;
     pxCurrentTCB->xState = TASK_READY;
 
-    // Call scheduler from ISR
-    portCALL_SCHEDULER_FROM_ISR();
+    // Switch task
+    pxTaskToRunNext = pxTaskToRun;
+    traceMASK_YIELD_BEGIN();
+    vPortYield();
+    traceMASK_YIELD_END();
+
+    taskEXIT_CRITICAL();
 }
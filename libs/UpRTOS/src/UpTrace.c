@@ -0,0 +1,179 @@
+/*
+ * UpTrace.c
+ *
+ *  Created on: 29 abr 2024
+ *      Author: User123
+ */
+
+/* Private includes -----------------------------------*/
+#include <UpRTOS/UpTrace.h>
+#include <UpRTOS/UpPortable.h>
+
+#if configUSE_CRITICAL_TRACE == (1)
+
+/* Private defines ---------------------------------------------------*/
+
+/* Private macros ----------------------------------------------------*/
+
+/* Private typedefs --------------------------------------------------*/
+
+/* Private prototype function ----------------------------------------*/
+
+/* Private variables -------------------------------------------------*/
+static TraceSite_t xTraceSites[configTRACE_MAX_SITES];
+static uint16_t uxTraceNumberOfSites = 0;
+static uint16_t uxTraceDropped = 0;         // Sections not recorded: table full or open across a task switch
+
+// Start of the current masked section
+static const char *pcTraceFile = NULL;
+static uint16_t usTraceLine = 0;
+static uint16_t usTraceStartCount = 0;
+static UBaseType_t xTraceStartTick = pdFALSE;
+
+
+/* Reference function ------------------------------------------------*/
+/*!
+ * @name vTraceMaskBegin
+ * @brief Timestamp the start of a masked section, interrupts must be disabled
+ */
+void vTraceMaskBegin(const char *pcFile, uint16_t usLine)
+{
+    usTraceStartCount = TA1R;
+    xTraceStartTick = xPortTickPending();
+    pcTraceFile = pcFile;
+    usTraceLine = usLine;
+}
+
+/*!
+ * @name vTraceMaskEnd
+ * @brief Measure the masked section and record it on its call site,
+ *        interrupts must still be disabled
+ */
+void vTraceMaskEnd(void)
+{
+    uint16_t usNow = TA1R;
+    uint16_t usPeriod = TA1CCR0 + 1;
+    uint16_t usElapsed;
+    uint16_t uxIndex;
+
+    if(pcTraceFile == NULL) return;
+
+    // TA1 counts up to TA1CCR0, the Systick ISR cannot run while masked, so
+    // xTickCount does not move and the timer wrap is found from the counter
+    // and the pending tick (a yield request sets the same CCIFG)
+    if(usNow >= usTraceStartCount)
+    {
+        usElapsed = usNow - usTraceStartCount;
+
+        // The period expired in between and the counter is past the start again
+        if( !xTraceStartTick && xPortTickPending() ) usElapsed += usPeriod;
+    }
+    else
+    {
+        usElapsed = usPeriod - usTraceStartCount + usNow;
+    }
+
+    // Find the call site (the same __FILE__ literal is shared by its section)
+    for(uxIndex = 0; uxIndex < uxTraceNumberOfSites; uxIndex++)
+    {
+        if(xTraceSites[uxIndex].usLine == usTraceLine && xTraceSites[uxIndex].pcFile == pcTraceFile) break;
+    }
+    if(uxIndex == uxTraceNumberOfSites)
+    {
+        if(uxTraceNumberOfSites >= configTRACE_MAX_SITES)
+        {
+            if(uxTraceDropped < UINT16_MAX) uxTraceDropped++;
+            pcTraceFile = NULL;
+            return;
+        }
+        xTraceSites[uxIndex].pcFile = pcTraceFile;
+        xTraceSites[uxIndex].usLine = usTraceLine;
+        uxTraceNumberOfSites++;
+    }
+
+    // Update
+    TraceSite_t *pxSite = &xTraceSites[uxIndex];
+    if(usElapsed > pxSite->usMax) pxSite->usMax = usElapsed;
+
+    uint16_t usBucket = usElapsed >> configTRACE_BUCKET_SHIFT;
+    uint8_t ucBucket = 0;
+    while(usBucket && ucBucket < (configTRACE_HISTOGRAM_BUCKETS - 1))
+    {
+        usBucket >>= 1;
+        ucBucket++;
+    }
+    if(pxSite->ucHistogram[ucBucket] < UINT8_MAX) pxSite->ucHistogram[ucBucket]++;
+
+    pcTraceFile = NULL;
+}
+
+/*!
+ * @name vTraceMaskPause
+ * @brief Record the open section before a kernel yield and keep its call
+ *        site in *pxMark, on the stack of the yielding task
+ */
+void vTraceMaskPause(TraceMark_t *pxMark)
+{
+    pxMark->pcFile = pcTraceFile;
+    pxMark->usLine = usTraceLine;
+    vTraceMaskEnd();
+}
+
+/*!
+ * @name vTraceMaskResume
+ * @brief Start the section of *pxMark again once the task runs, interrupts
+ *        must be disabled
+ */
+void vTraceMaskResume(const TraceMark_t *pxMark)
+{
+    if(pxMark->pcFile != NULL) vTraceMaskBegin(pxMark->pcFile, pxMark->usLine);
+}
+
+/*!
+ * @name vTraceMaskSwitch
+ * @brief Called on a context switch: a section still open was not paused
+ *        and would end on another task, drop it
+ */
+void vTraceMaskSwitch(void)
+{
+    if(pcTraceFile == NULL) return;
+
+    if(uxTraceDropped < UINT16_MAX) uxTraceDropped++;
+    pcTraceFile = NULL;
+}
+
+/*!
+ * @name uxTraceGetSites
+ * @brief Get the recorded call sites
+ * @return Number of entries in *ppxSites
+ */
+uint16_t uxTraceGetSites(const TraceSite_t **ppxSites)
+{
+    if(ppxSites != NULL) *ppxSites = xTraceSites;
+
+    return uxTraceNumberOfSites;
+}
+
+uint16_t uxTraceGetDropped(void)
+{
+    return uxTraceDropped;
+}
+
+void vTraceReset(void)
+{
+    uint16_t uxIndex;
+    uint8_t ucBucket;
+
+    portENTER_CRITICAL();
+
+    for(uxIndex = 0; uxIndex < uxTraceNumberOfSites; uxIndex++)
+    {
+        xTraceSites[uxIndex].usMax = 0;
+        for(ucBucket = 0; ucBucket < configTRACE_HISTOGRAM_BUCKETS; ucBucket++) xTraceSites[uxIndex].ucHistogram[ucBucket] = 0;
+    }
+    uxTraceDropped = 0;
+
+    portEXIT_CRITICAL();
+}
+
+#endif /* configUSE_CRITICAL_TRACE */
@@ -0,0 +1,362 @@
+/*
+ * uplog.c
+ *
+ *  Created on: 14 may 2024
+ *      Author: User123
+ *
+ * Host decoder of the UpRTOS tokenized log: rebuilds the text of the records
+ * sent by the log daemon, using the formats of UpLogMessages.def. See
+ * README.md.
+ */
+
+/* Private includes -----------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <UpRTOSConfig.h>
+
+/* Private defines ---------------------------------------------------*/
+#define logMAX_MESSAGES         (255)       // Ids are one byte, 0 is LOG_ID_DROPPED
+#define logNAME_LENGTH          (40)
+#define logFORMAT_LENGTH        (160)
+#define logRECORD_HEADER_SIZE   (4)
+#define logMAX_ARGS             (8)
+#define logMAX_RECORD           (logRECORD_HEADER_SIZE + 2*logMAX_ARGS)
+#define logMAX_FRAME            (256)
+
+#define logINPUT_COBS           (0)         // Records sent with HAL_FRAME_Send (COBS + CRC-16)
+#define logINPUT_RAW            (1)         // Records written straight to the UART
+
+/* Private typedefs --------------------------------------------------*/
+typedef struct
+{
+    char acName[logNAME_LENGTH];
+    char acFormat[logFORMAT_LENGTH];
+    int xWords;                         // 16-bit arguments the format takes
+} LogMessage_t;
+
+/* Private prototype function ----------------------------------------*/
+static int xLogLoadTable(const char *pcFile);
+static int xLogCountWords(const char *pcFormat);
+static void vLogPrintRecord(const uint8_t *pucRecord, int xLength);
+static int xLogCobsDecode(uint8_t *pucFrame, int xLength);
+static uint16_t usLogCrc16(const uint8_t *pucData, int xLength);
+
+/* Private variables -------------------------------------------------*/
+static LogMessage_t xMessages[logMAX_MESSAGES + 1];
+static int xNumberOfMessages = 0;
+static unsigned long ulTickRate = configTICK_RATE_HZ;
+static unsigned long long ullTicks = 0;     // Tick count unwrapped from the 16-bit stamps
+static int xHaveTicks = 0;
+static unsigned long ulBadRecords = 0;
+
+
+/* Reference function ------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    const char *pcTable = NULL;
+    const char *pcInput = NULL;
+    int xInput = logINPUT_COBS;
+    FILE *pxIn = stdin;
+    uint8_t ucBuffer[logMAX_FRAME];
+    int xLength = 0;
+    int xIndex;
+    int c;
+
+    for(xIndex = 1; xIndex < argc; xIndex++)
+    {
+        if(strcmp(argv[xIndex], "-r") == 0 && xIndex + 1 < argc) ulTickRate = strtoul(argv[++xIndex], NULL, 0);
+        else if(strcmp(argv[xIndex], "--raw") == 0) xInput = logINPUT_RAW;
+        else if(argv[xIndex][0] != '-' && pcTable == NULL) pcTable = argv[xIndex];
+        else if(argv[xIndex][0] != '-' && pcInput == NULL) pcInput = argv[xIndex];
+        else pcTable = NULL, xIndex = argc;
+    }
+    if(pcTable == NULL || ulTickRate == 0)
+    {
+        fprintf(stderr, "usage: %s [-r tick_rate_hz] [--raw] UpLogMessages.def [capture]\n", argv[0]);
+        return 2;
+    }
+
+    if(!xLogLoadTable(pcTable)) return 1;
+
+    if(pcInput != NULL && (pxIn = fopen(pcInput, "rb")) == NULL)
+    {
+        perror(pcInput);
+        return 1;
+    }
+
+    while((c = fgetc(pxIn)) != EOF)
+    {
+        if(xInput == logINPUT_COBS)
+        {
+            if(c != 0x00)
+            {
+                // An overlong frame is garbage, skip to the next delimiter
+                if(xLength < logMAX_FRAME) ucBuffer[xLength] = (uint8_t)c;
+                xLength++;
+                continue;
+            }
+            if(xLength > 0)
+            {
+                int xDecoded = (xLength <= logMAX_FRAME) ? xLogCobsDecode(ucBuffer, xLength) : -1;
+                if(xDecoded < 2 || usLogCrc16(ucBuffer, xDecoded) != 0) ulBadRecords++;
+                else vLogPrintRecord(ucBuffer, xDecoded - 2);
+            }
+            xLength = 0;
+        }
+        else
+        {
+            ucBuffer[xLength++] = (uint8_t)c;
+            if(xLength < logRECORD_HEADER_SIZE) continue;
+
+            // The raw stream has no framing, a record that does not match its
+            // format is skipped one byte at a time until one does
+            int xId = ucBuffer[0];
+            int xArgs = ucBuffer[1];
+            if(xId > xNumberOfMessages || xArgs > logMAX_ARGS || xArgs != xMessages[xId].xWords)
+            {
+                ulBadRecords++;
+                memmove(ucBuffer, ucBuffer + 1, --xLength);
+                continue;
+            }
+            if(xLength == logRECORD_HEADER_SIZE + 2*xArgs)
+            {
+                vLogPrintRecord(ucBuffer, xLength);
+                xLength = 0;
+            }
+        }
+    }
+
+    if(pxIn != stdin) fclose(pxIn);
+    if(ulBadRecords) fprintf(stderr, "uplog: %lu bad records skipped\n", ulBadRecords);
+
+    return 0;
+}
+
+
+/* Private reference functions -----------------------------------*/
+/**
+ * @brief Read the LOG_MESSAGE(identifier, "format") entries, in order: the
+ *        first one is id 1, like the LogId_t enum of UpLog.h.
+ */
+static int xLogLoadTable(const char *pcFile)
+{
+    char acLine[512];
+    FILE *pxFile = fopen(pcFile, "r");
+    int xLine = 0;
+
+    if(pxFile == NULL)
+    {
+        perror(pcFile);
+        return 0;
+    }
+
+    strcpy(xMessages[0].acName, "LOG_ID_DROPPED");
+    strcpy(xMessages[0].acFormat, "%u records dropped (log buffer full)");
+    xMessages[0].xWords = 1;
+
+    while(fgets(acLine, sizeof(acLine), pxFile) != NULL)
+    {
+        char *pc = acLine;
+        char *pcOut;
+        LogMessage_t *pxMessage;
+
+        xLine++;
+        while(*pc == ' ' || *pc == '\t') pc++;
+        if(strncmp(pc, "LOG_MESSAGE(", 12) != 0) continue;
+        pc += 12;
+
+        if(xNumberOfMessages == logMAX_MESSAGES)
+        {
+            fprintf(stderr, "%s:%d: more than %d messages\n", pcFile, xLine, logMAX_MESSAGES);
+            break;
+        }
+        pxMessage = &xMessages[xNumberOfMessages + 1];
+
+        // Identifier
+        while(*pc == ' ' || *pc == '\t') pc++;
+        pcOut = pxMessage->acName;
+        while((*pc == '_' || (*pc >= '0' && *pc <= '9') || (*pc >= 'A' && *pc <= 'Z') || (*pc >= 'a' && *pc <= 'z'))
+              && pcOut < &pxMessage->acName[logNAME_LENGTH - 1]) *pcOut++ = *pc++;
+        *pcOut = '\0';
+
+        // String literal (common escapes only)
+        while(*pc == ' ' || *pc == '\t' || *pc == ',') pc++;
+        if(*pc++ != '"' || pxMessage->acName[0] == '\0')
+        {
+            fprintf(stderr, "%s:%d: expected LOG_MESSAGE(identifier, \"format\")\n", pcFile, xLine);
+            fclose(pxFile);
+            return 0;
+        }
+        pcOut = pxMessage->acFormat;
+        while(*pc != '\0' && *pc != '"' && pcOut < &pxMessage->acFormat[logFORMAT_LENGTH - 1])
+        {
+            if(*pc == '\\' && pc[1] != '\0')
+            {
+                pc++;
+                *pcOut++ = (*pc == 'n') ? '\n' : (*pc == 't') ? '\t' : *pc;
+                pc++;
+            }
+            else *pcOut++ = *pc++;
+        }
+        *pcOut = '\0';
+
+        pxMessage->xWords = xLogCountWords(pxMessage->acFormat);
+        if(pxMessage->xWords < 0 || pxMessage->xWords > logMAX_ARGS)
+        {
+            fprintf(stderr, "%s:%d: unsupported format \"%s\"\n", pcFile, xLine, pxMessage->acFormat);
+            fclose(pxFile);
+            return 0;
+        }
+        xNumberOfMessages++;
+    }
+
+    fclose(pxFile);
+
+    return 1;
+}
+
+// 16-bit words taken by the conversions of a format, -1 if unsupported
+static int xLogCountWords(const char *pcFormat)
+{
+    int xWords = 0;
+
+    while(*pcFormat)
+    {
+        if(*pcFormat++ != '%') continue;
+        if(*pcFormat == '%')
+        {
+            pcFormat++;
+            continue;
+        }
+        pcFormat += strspn(pcFormat, "-+ #0123456789.");
+        if(*pcFormat == 'l')
+        {
+            pcFormat++;
+            xWords++;
+        }
+        if(*pcFormat == '\0' || strchr("diuxXoc", *pcFormat) == NULL) return -1;
+        pcFormat++;
+        xWords++;
+    }
+
+    return xWords;
+}
+
+static void vLogPrintRecord(const uint8_t *pucRecord, int xLength)
+{
+    const LogMessage_t *pxMessage;
+    const char *pcFormat;
+    char acSpec[32];
+    int xId, xArgs, xWord = 0;
+    uint16_t usTicks;
+
+    if(xLength < logRECORD_HEADER_SIZE) return;
+    xId = pucRecord[0];
+    xArgs = pucRecord[1];
+    usTicks = (uint16_t)(pucRecord[2] | (pucRecord[3] << 8));
+    if(xId > xNumberOfMessages || xLength != logRECORD_HEADER_SIZE + 2*xArgs || xArgs != xMessages[xId].xWords)
+    {
+        ulBadRecords++;
+        return;
+    }
+    pxMessage = &xMessages[xId];
+
+    // Records come in order, so the 16-bit stamps only move forward
+    if(xHaveTicks) ullTicks += (uint16_t)(usTicks - (uint16_t)ullTicks);
+    else ullTicks = usTicks, xHaveTicks = 1;
+
+    printf("%10.3f %s: ", (double)ullTicks / ulTickRate, pxMessage->acName);
+
+    for(pcFormat = pxMessage->acFormat; *pcFormat; )
+    {
+        const char *pcStart = pcFormat;
+        size_t xSpec;
+        int xLong = 0;
+        char cConversion;
+        unsigned long ulValue;
+
+        if(*pcFormat != '%' || pcFormat[1] == '%')
+        {
+            putchar(*pcFormat);
+            pcFormat += (*pcFormat == '%') ? 2 : 1;
+            continue;
+        }
+
+        pcFormat++;
+        pcFormat += strspn(pcFormat, "-+ #0123456789.");
+        xSpec = (size_t)(pcFormat - pcStart);
+        if(*pcFormat == 'l')
+        {
+            xLong = 1;
+            pcFormat++;
+        }
+        cConversion = *pcFormat++;
+
+        ulValue = (unsigned long)(pucRecord[4 + 2*xWord] | (pucRecord[5 + 2*xWord] << 8));
+        xWord++;
+        if(xLong)
+        {
+            ulValue |= (unsigned long)(pucRecord[4 + 2*xWord] | (pucRecord[5 + 2*xWord] << 8)) << 16;
+            xWord++;
+        }
+
+        // Same flags and width, the value widened to long
+        if(xSpec > sizeof(acSpec) - 3) xSpec = sizeof(acSpec) - 3;
+        memcpy(acSpec, pcStart, xSpec);
+        if(cConversion == 'c')
+        {
+            acSpec[xSpec] = 'c';
+            acSpec[xSpec + 1] = '\0';
+            printf(acSpec, (int)(ulValue & 0xFF));
+        }
+        else if(cConversion == 'd' || cConversion == 'i')
+        {
+            long lValue = xLong ? (long)(int32_t)ulValue : (long)(int16_t)ulValue;
+            acSpec[xSpec] = 'l';
+            acSpec[xSpec + 1] = 'd';
+            acSpec[xSpec + 2] = '\0';
+            printf(acSpec, lValue);
+        }
+        else
+        {
+            acSpec[xSpec] = 'l';
+            acSpec[xSpec + 1] = cConversion;
+            acSpec[xSpec + 2] = '\0';
+            printf(acSpec, ulValue);
+        }
+    }
+    putchar('\n');
+    fflush(stdout);
+}
+
+// In place, returns the decoded length or -1
+static int xLogCobsDecode(uint8_t *pucFrame, int xLength)
+{
+    int xIn = 0, xOut = 0;
+
+    while(xIn < xLength)
+    {
+        int xCode = pucFrame[xIn++];
+        if(xCode == 0 || xIn + xCode - 1 > xLength) return -1;
+        for(int i = 1; i < xCode; i++) pucFrame[xOut++] = pucFrame[xIn++];
+        if(xCode != 0xFF && xIn < xLength) pucFrame[xOut++] = 0x00;
+    }
+
+    return xOut;
+}
+
+// CRC-16/CCITT-FALSE, as HAL_FRAME_Crc16: a frame followed by its CRC gives 0
+static uint16_t usLogCrc16(const uint8_t *pucData, int xLength)
+{
+    uint16_t usCrc = 0xFFFF;
+
+    while(xLength--)
+    {
+        usCrc ^= (uint16_t)(*pucData++) << 8;
+        for(int i = 0; i < 8; i++) usCrc = (usCrc & 0x8000) ? (uint16_t)((usCrc << 1) ^ 0x1021) : (uint16_t)(usCrc << 1);
+    }
+
+    return usCrc;
+}
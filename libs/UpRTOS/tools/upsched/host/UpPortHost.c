@@ -0,0 +1,54 @@
+/*
+ * UpPortHost.c
+ *
+ *  Created on: 8 may 2024
+ *      Author: User123
+ *
+ * Host port for upsched. There is no context to save: the simulator reads
+ * pxCurrentTCB after each scheduler call to know which task owns the CPU.
+ */
+
+/* Private includes -----------------------------------*/
+#include <UpRTOS/UpPortable.h>
+#include <UpRTOS/UpTask.h>
+
+/* Private variables -------------------------------------------------*/
+volatile UBaseType_t uxCriticalNesting = portINITIAL_CRITICAL_NESTING;
+
+
+/* Reference function ------------------------------------------------*/
+UBaseType_t xPortSetuptTimerInterrupt(void)
+{
+    return pdTRUE;
+}
+
+StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters)
+{
+    (void)pxCode;
+    (void)pvParameters;
+
+    return pxTopOfStack;
+}
+
+void vPortStartFirstTask(void)
+{
+    // The simulator runs pxCurrentTCB from here on
+    uxCriticalNesting = 0;
+}
+
+void vPortYield(void)
+{
+    vTaskSwitchContext();
+}
+
+void vPortYieldFromISR(void)
+{
+    // The target pends the Systick by software: a switch without a tick
+    vTaskSwitchContext();
+}
+
+void vPortTickHandler(void)
+{
+    vTaskIncrementTick();
+    vTaskSwitchContext();
+}
@@ -0,0 +1,31 @@
+/*
+ * UpRTOSConfig.h
+ *
+ *  Created on: 8 may 2024
+ *      Author: User123
+ *
+ * Host build of the kernel for upsched: the target configuration with room
+ * for larger task sets. The scheduling options are left as configured.
+ */
+
+#ifndef UPSCHED_HOST_UPRTOSCONFIG_H_
+#define UPSCHED_HOST_UPRTOSCONFIG_H_
+
+#include "../../../UpRTOSConfig.h"
+
+#undef configMAX_TASKS
+#define configMAX_TASKS             (16)
+#undef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE       (8192)
+
+// Not simulated
+#undef configUSE_DEFERRED_CALLS
+#define configUSE_DEFERRED_CALLS    (0)
+#undef configUSE_BASIC_TASKS
+#define configUSE_BASIC_TASKS       (0)
+#undef configUSE_CRITICAL_TRACE
+#define configUSE_CRITICAL_TRACE    (0)
+#undef configGENERATE_RUN_TIME_STATS
+#define configGENERATE_RUN_TIME_STATS   (0)
+
+#endif /* UPSCHED_HOST_UPRTOSCONFIG_H_ */
@@ -0,0 +1,34 @@
+/*
+ * msp430.h
+ *
+ *  Created on: 8 may 2024
+ *      Author: User123
+ *
+ * Host stand-in for the TI header, only what the UpRTOS kernel sources use.
+ * Interrupts do not exist on the host, the simulator calls the scheduler.
+ */
+
+#ifndef UPSCHED_HOST_MSP430_H_
+#define UPSCHED_HOST_MSP430_H_
+
+#include <stdint.h>
+
+#define __interrupt
+#define asm(x)      // MSP430 inline assembly (debug markers, nop)
+
+static inline void __enable_interrupt(void) {}
+static inline void __disable_interrupt(void) {}
+static inline uint16_t __get_SR_register(void) { return 0; }
+static inline void __bis_SR_register(uint16_t usMask) { (void)usMask; }
+static inline void __no_operation(void) {}
+
+#define BIT0    (0x0001)
+#define BIT1    (0x0002)
+#define BIT2    (0x0004)
+#define BIT3    (0x0008)
+#define BIT4    (0x0010)
+#define BIT5    (0x0020)
+#define BIT6    (0x0040)
+#define BIT7    (0x0080)
+
+#endif /* UPSCHED_HOST_MSP430_H_ */
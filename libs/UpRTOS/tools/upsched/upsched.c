@@ -0,0 +1,399 @@
+/*
+ * upsched.c
+ *
+ *  Created on: 8 may 2024
+ *      Author: User123
+ *
+ * Schedulability check of a periodic task set for the UpRTOS fixed priority
+ * scheduler: response time analysis, cross-checked by running the kernel
+ * scheduler (UpTask.c built for the host) in virtual time. See README.md.
+ */
+
+/* Private includes -----------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <UpRTOS/UpTask.h>
+
+#if configUSE_EDF_SCHEDULING == (1)
+#error "upsched analyses the fixed priority policy, set configUSE_EDF_SCHEDULING to 0"
+#endif
+
+/* Private defines ---------------------------------------------------*/
+#define schedMAX_TASKS          (configMAX_TASKS)
+#define schedNAME_LENGTH        (16)
+#define schedTICK_US            (1000000UL / configTICK_RATE_HZ)
+#define schedMAX_HORIZON_US     (60000000ULL)   // Default horizon cap (60 s of virtual time)
+
+/* Private typedefs --------------------------------------------------*/
+typedef struct
+{
+    // Task set (microseconds)
+    char acName[schedNAME_LENGTH];
+    unsigned long ulPeriod;
+    unsigned long ulWcet;
+    unsigned long ulDeadline;
+    unsigned long ulBlocking;
+    UBaseType_t uxPriority;
+
+    // Analysis
+    unsigned long ulResponseBound;
+    int xSchedulable;
+
+    // Simulation
+    TaskHandle_t xHandle;
+    TickType_t xLastWakeTime;
+    unsigned long long ullRelease;      // Release of the current job
+    unsigned long ulRemaining;          // Execution left of the current job
+    unsigned long ulMaxResponse;
+    unsigned long ulJobs;
+    unsigned long ulMisses;
+} SchedTask_t;
+
+/* Private prototype function ----------------------------------------*/
+static int xSchedLoad(const char *pcFile);
+static void vSchedAnalyse(void);
+static void vSchedSimulate(unsigned long long ullHorizon);
+static unsigned long long ullSchedHyperperiod(void);
+static void vSchedDummyTask(void *pvParams);
+static int xSchedYieldCheck(void);
+
+/* Private variables -------------------------------------------------*/
+static SchedTask_t xTasks[schedMAX_TASKS];
+static int xNumberOfTasks = 0;
+static unsigned long ulTickOverhead = 0;        // Systick ISR execution time (us)
+
+
+/* Reference function ------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    unsigned long long ullHorizon = 0;
+    unsigned long ulMaxDeadline = 0;
+    const char *pcFile = NULL;
+    int xIndex;
+    int xFailed = 0;
+
+    if(argc == 2 && strcmp(argv[1], "-y") == 0) return xSchedYieldCheck();
+
+    for(xIndex = 1; xIndex < argc; xIndex++)
+    {
+        if(strcmp(argv[xIndex], "-o") == 0 && xIndex + 1 < argc) ulTickOverhead = strtoul(argv[++xIndex], NULL, 0);
+        else if(strcmp(argv[xIndex], "-t") == 0 && xIndex + 1 < argc) ullHorizon = strtoull(argv[++xIndex], NULL, 0) * 1000ULL;
+        else if(argv[xIndex][0] != '-' && pcFile == NULL) pcFile = argv[xIndex];
+        else pcFile = NULL, xIndex = argc;
+    }
+    if(pcFile == NULL)
+    {
+        fprintf(stderr, "usage: upsched [-o tick_overhead_us] [-t horizon_ms] taskset.txt\n       upsched -y\n");
+        return 2;
+    }
+    if(ulTickOverhead >= schedTICK_US)
+    {
+        fprintf(stderr, "upsched: the tick overhead must be below the tick period (%lu us)\n", schedTICK_US);
+        return 2;
+    }
+    if( !xSchedLoad(pcFile) ) return 2;
+
+    if(ullHorizon == 0)
+    {
+        // One hyperperiod, plus the longest deadline so its last jobs are checked
+        ullHorizon = ullSchedHyperperiod();
+        for(xIndex = 0; xIndex < xNumberOfTasks; xIndex++)
+        {
+            if(xTasks[xIndex].ulDeadline > ulMaxDeadline) ulMaxDeadline = xTasks[xIndex].ulDeadline;
+        }
+        ullHorizon += ulMaxDeadline;
+        if(ullHorizon > schedMAX_HORIZON_US) ullHorizon = schedMAX_HORIZON_US;
+    }
+
+    vSchedAnalyse();
+    vSchedSimulate(ullHorizon);
+
+    printf("tick %lu us, tick overhead %lu us, simulated %llu ms\n\n", schedTICK_US, ulTickOverhead, ullHorizon / 1000ULL);
+    printf("%-15s %4s %9s %9s %9s %9s %10s %10s %6s\n", "task", "prio", "T(us)", "C(us)", "D(us)", "B(us)", "R_rta(us)", "R_sim(us)", "misses");
+    for(xIndex = 0; xIndex < xNumberOfTasks; xIndex++)
+    {
+        SchedTask_t *pxTask = &xTasks[xIndex];
+        char acBound[16];
+
+        if(pxTask->xSchedulable) snprintf(acBound, sizeof(acBound), "%lu", pxTask->ulResponseBound);
+        else snprintf(acBound, sizeof(acBound), ">D");
+
+        printf("%-15s %4u %9lu %9lu %9lu %9lu %10s %10lu %6lu%s\n",
+               pxTask->acName, (unsigned)pxTask->uxPriority, pxTask->ulPeriod, pxTask->ulWcet,
+               pxTask->ulDeadline, pxTask->ulBlocking, acBound, pxTask->ulMaxResponse, pxTask->ulMisses,
+               (pxTask->xSchedulable && pxTask->ulMaxResponse > pxTask->ulResponseBound) ? "  <- above the bound" : "");
+
+        if( !pxTask->xSchedulable || pxTask->ulMisses ) xFailed = 1;
+    }
+
+    printf("\n%s\n", xFailed ? "NOT SCHEDULABLE" : "SCHEDULABLE");
+
+    return xFailed;
+}
+
+
+/* Private reference functions -----------------------------------*/
+/*!
+ * @brief Read the task set, one task per line:
+ *        name period_us wcet_us deadline_us priority [blocking_us]
+ *        A deadline of 0 means the period. '#' starts a comment.
+ */
+static int xSchedLoad(const char *pcFile)
+{
+    char acLine[128];
+    int xLine = 0;
+    FILE *pxFile = fopen(pcFile, "r");
+
+    if(pxFile == NULL)
+    {
+        perror(pcFile);
+        return 0;
+    }
+
+    while(fgets(acLine, sizeof(acLine), pxFile) != NULL)
+    {
+        SchedTask_t xTask;
+        SchedTask_t *pxTask = &xTask;
+        unsigned uPriority;
+        char *pcComment = strchr(acLine, '#');
+        int xFields;
+
+        xLine++;
+        if(pcComment != NULL) *pcComment = '\0';
+
+        memset(pxTask, 0, sizeof(*pxTask));
+        xFields = sscanf(acLine, "%15s %lu %lu %lu %u %lu", pxTask->acName, &pxTask->ulPeriod,
+                         &pxTask->ulWcet, &pxTask->ulDeadline, &uPriority, &pxTask->ulBlocking);
+        if(xFields <= 0) continue;
+        if(xFields < 5 || pxTask->ulPeriod == 0 || pxTask->ulWcet == 0)
+        {
+            fprintf(stderr, "%s:%d: expected 'name period_us wcet_us deadline_us priority [blocking_us]'\n", pcFile, xLine);
+            fclose(pxFile);
+            return 0;
+        }
+        if(xNumberOfTasks == schedMAX_TASKS)
+        {
+            fprintf(stderr, "%s:%d: more than %d tasks\n", pcFile, xLine, schedMAX_TASKS);
+            fclose(pxFile);
+            return 0;
+        }
+
+        // Delays are counted in ticks, so releases only happen on a tick
+        if(pxTask->ulPeriod % schedTICK_US)
+        {
+            fprintf(stderr, "%s:%d: the period must be a multiple of the tick (%lu us)\n", pcFile, xLine, schedTICK_US);
+            fclose(pxFile);
+            return 0;
+        }
+        if(pxTask->ulDeadline == 0) pxTask->ulDeadline = pxTask->ulPeriod;
+
+        // Same limits as xTaskCreate
+        if(uPriority <= configIDLE_PRIORITY)
+        {
+            fprintf(stderr, "%s:%d: priority %u is reserved for the idle task\n", pcFile, xLine, uPriority);
+            fclose(pxFile);
+            return 0;
+        }
+        if(uPriority > configMAX_PRIORITIES)
+        {
+            fprintf(stderr, "%s:%d: warning: priority %u is clamped to configMAX_PRIORITIES (%d)\n", pcFile, xLine, uPriority, configMAX_PRIORITIES);
+            uPriority = configMAX_PRIORITIES;
+        }
+        pxTask->uxPriority = (UBaseType_t)uPriority;
+
+        xTasks[xNumberOfTasks++] = xTask;
+    }
+
+    fclose(pxFile);
+
+    if(xNumberOfTasks == 0)
+    {
+        fprintf(stderr, "%s: no tasks\n", pcFile);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*!
+ * @brief Response time analysis with synchronous release:
+ *        R = C + B + ceil(R/Ttick)*Ctick + sum( ceil(R/Tj)*Cj )
+ *        over the other tasks of higher or equal priority. vTaskSwitchContext
+ *        keeps the running task on a tie, so equal priorities are counted
+ *        as interference, which is an upper bound.
+ */
+static void vSchedAnalyse(void)
+{
+    int xIndex, xOther;
+
+    for(xIndex = 0; xIndex < xNumberOfTasks; xIndex++)
+    {
+        SchedTask_t *pxTask = &xTasks[xIndex];
+        unsigned long long ullResponse = pxTask->ulWcet + pxTask->ulBlocking;
+        unsigned long long ullNext;
+
+        while(1)
+        {
+            ullNext = pxTask->ulWcet + pxTask->ulBlocking;
+            ullNext += ((ullResponse + schedTICK_US - 1) / schedTICK_US) * ulTickOverhead;
+            for(xOther = 0; xOther < xNumberOfTasks; xOther++)
+            {
+                if(xOther == xIndex || xTasks[xOther].uxPriority < pxTask->uxPriority) continue;
+                ullNext += ((ullResponse + xTasks[xOther].ulPeriod - 1) / xTasks[xOther].ulPeriod) * xTasks[xOther].ulWcet;
+            }
+
+            if(ullNext == ullResponse || ullNext > pxTask->ulDeadline) break;
+            ullResponse = ullNext;
+        }
+
+        pxTask->xSchedulable = (ullNext <= pxTask->ulDeadline);
+        pxTask->ulResponseBound = (unsigned long)ullNext;
+    }
+}
+
+/*!
+ * @brief Discrete event simulation: the kernel selects the task, the
+ *        simulator only spends its execution time. Events are the Systick
+ *        (vPortTickHandler) and job completions, where the task calls
+ *        vTaskDelayUntil as a periodic UpRTOS task does. Blocking is not
+ *        simulated.
+ */
+static void vSchedSimulate(unsigned long long ullHorizon)
+{
+    unsigned long long ullNow = 0;
+    unsigned long long ullNextTick = schedTICK_US;
+    unsigned long long ullIsrEnd = 0;
+    int xIndex;
+
+    for(xIndex = 0; xIndex < xNumberOfTasks; xIndex++)
+    {
+        SchedTask_t *pxTask = &xTasks[xIndex];
+
+        if( xTaskCreate(vSchedDummyTask, configMINIMAL_STACK_SIZE, pxTask, pxTask->uxPriority, &pxTask->xHandle) != pdTRUE )
+        {
+            fprintf(stderr, "upsched: xTaskCreate failed for %s\n", pxTask->acName);
+            exit(2);
+        }
+        pxTask->ulRemaining = pxTask->ulWcet;
+    }
+
+    vTaskStartScheduller();
+
+    while(ullNow < ullHorizon)
+    {
+        TaskHandle_t xCurrent = xTaskGetCurrentTaskHandle();
+        SchedTask_t *pxTask = NULL;
+        unsigned long long ullStart = (ullNow > ullIsrEnd) ? ullNow : ullIsrEnd;
+
+        for(xIndex = 0; xIndex < xNumberOfTasks; xIndex++)
+        {
+            if(xTasks[xIndex].xHandle == xCurrent) pxTask = &xTasks[xIndex];
+        }
+
+        if(pxTask != NULL && ullStart + pxTask->ulRemaining <= ullNextTick)
+        {
+            unsigned long ulResponse;
+
+            // Job completion
+            ullNow = ullStart + pxTask->ulRemaining;
+            ulResponse = (unsigned long)(ullNow - pxTask->ullRelease);
+            if(ulResponse > pxTask->ulMaxResponse) pxTask->ulMaxResponse = ulResponse;
+            if(ulResponse > pxTask->ulDeadline) pxTask->ulMisses++;
+            pxTask->ulJobs++;
+
+            pxTask->ullRelease += pxTask->ulPeriod;
+            pxTask->ulRemaining = pxTask->ulWcet;
+            vTaskDelayUntil(&pxTask->xLastWakeTime, (TickType_t)(pxTask->ulPeriod / schedTICK_US));
+        }
+        else
+        {
+            // Systick
+            if(pxTask != NULL && ullStart < ullNextTick) pxTask->ulRemaining -= (unsigned long)(ullNextTick - ullStart);
+            ullNow = ullNextTick;
+            ullNextTick += schedTICK_US;
+            ullIsrEnd = ullNow + ulTickOverhead;
+            vPortTickHandler();
+        }
+    }
+
+    // Jobs still pending past their deadline
+    for(xIndex = 0; xIndex < xNumberOfTasks; xIndex++)
+    {
+        SchedTask_t *pxTask = &xTasks[xIndex];
+
+        if(pxTask->ullRelease + pxTask->ulDeadline < ullHorizon)
+        {
+            unsigned long ulResponse = (unsigned long)(ullHorizon - pxTask->ullRelease);
+            if(ulResponse > pxTask->ulMaxResponse) pxTask->ulMaxResponse = ulResponse;
+            pxTask->ulMisses++;
+        }
+    }
+}
+
+static unsigned long long ullSchedHyperperiod(void)
+{
+    unsigned long long ullLcm = 1;
+    int xIndex;
+
+    for(xIndex = 0; xIndex < xNumberOfTasks; xIndex++)
+    {
+        unsigned long long ullA = ullLcm, ullB = xTasks[xIndex].ulPeriod, ullTmp;
+
+        while(ullB != 0)
+        {
+            ullTmp = ullA % ullB;
+            ullA = ullB;
+            ullB = ullTmp;
+        }
+        ullLcm = (ullLcm / ullA) * xTasks[xIndex].ulPeriod;
+        if(ullLcm > schedMAX_HORIZON_US) return schedMAX_HORIZON_US;
+    }
+
+    return ullLcm;
+}
+
+/*!
+ * @brief Kernel check of a switch without a tick (portYIELD_FROM_ISR alone):
+ *        an interrupt wakes a higher priority task over a running one, which
+ *        must run again once that task blocks.
+ */
+static int xSchedYieldCheck(void)
+{
+    TaskHandle_t xLow, xHigh;
+    UBaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    int xFailed = 0;
+
+    if( xTaskCreate(vSchedDummyTask, configMINIMAL_STACK_SIZE, NULL, configIDLE_PRIORITY + 1, &xLow) != pdTRUE ||
+        xTaskCreate(vSchedDummyTask, configMINIMAL_STACK_SIZE, NULL, configIDLE_PRIORITY + 2, &xHigh) != pdTRUE )
+    {
+        fprintf(stderr, "upsched: xTaskCreate failed\n");
+        return 2;
+    }
+    vTaskStartScheduller();
+
+    // High waits, low runs
+    (void)usTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if(xTaskGetCurrentTaskHandle() != xLow) xFailed = 1;
+
+    // Interrupt: wake high, no tick
+    vTaskNotifyGiveFromISR(xHigh, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    if(xTaskGetCurrentTaskHandle() != xHigh) xFailed = 1;
+
+    // High ends its take (the host returns from a wait before the wake)
+    // and waits again: the preempted task is back
+    (void)usTaskNotifyTake(pdTRUE, 0);
+    (void)usTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if(xTaskGetCurrentTaskHandle() != xLow) xFailed = 1;
+
+    printf("yield without a tick: %s\n", xFailed ? "FAILED" : "ok");
+
+    return xFailed;
+}
+
+static void vSchedDummyTask(void *pvParams)
+{
+    // Never called, the simulator plays the task bodies
+    (void)pvParams;
+}